@@ -0,0 +1,152 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+/// Функция AlignedAlloc() выделяет блок памяти, выровненный по границе <i>alignment</i>;
+/// при нехватке памяти выбрасывает std::bad_alloc
+/// alignment - требуемое выравнивание (степень двойки)
+/// bytes - размер блока в байтах
+inline void* AlignedAlloc(const size_t alignment, const size_t bytes)
+{
+#ifdef _WIN32
+    void* ptr = _aligned_malloc(bytes, alignment);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, bytes) != 0)
+    {
+        ptr = nullptr;
+    }
+#endif
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+/// Функция AlignedFree() освобождает блок, выделенный функцией AlignedAlloc()
+inline void AlignedFree(void* ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+/// Класс AlignedMatrix хранит матрицу в одном непрерывном блоке памяти,
+/// выровненном по границе кэш-линии. Строки располагаются друг за другом
+/// с шагом stride() элементов; при включенном дополнении шаг округляется
+/// вверх до целого числа кэш-линий, так что каждая строка начинается
+/// с выровненного адреса. Индексация matrix[i][j] сохранена.
+template <typename T>
+class AlignedMatrix
+{
+public:
+    /// выравнивание начала блока и строк (размер кэш-линии)
+    static constexpr size_t ALIGNMENT = 64;
+
+    AlignedMatrix() = default;
+
+    /// rows - количество строк
+    /// cols - количество столбцов
+    /// padded - дополнять ли строки до целого числа кэш-линий
+    AlignedMatrix(const size_t rows, const size_t cols, const bool padded = true)
+    {
+        resize(rows, cols, padded);
+    }
+
+    ~AlignedMatrix()
+    {
+        AlignedFree(data_);
+    }
+
+    AlignedMatrix(const AlignedMatrix&) = delete;
+    AlignedMatrix& operator=(const AlignedMatrix&) = delete;
+
+    AlignedMatrix(AlignedMatrix&& other) noexcept
+    {
+        swap(other);
+    }
+
+    AlignedMatrix& operator=(AlignedMatrix&& other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    /// Функция resize() меняет размеры матрицы; память перевыделяется
+    /// только если текущего блока недостаточно, поэтому матрицу можно
+    /// повторно использовать между запусками. Содержимое не сохраняется.
+    void resize(const size_t rows, const size_t cols, const bool padded = true)
+    {
+        constexpr size_t line = ALIGNMENT / sizeof(T);
+        const size_t stride = padded ? (cols + line - 1) / line * line : cols;
+        const size_t required = rows * stride;
+
+        if (required > capacity_)
+        {
+            AlignedFree(data_);
+            data_ = nullptr;
+            capacity_ = 0;
+
+            data_ = static_cast<T*>(AlignedAlloc(ALIGNMENT, required * sizeof(T)));
+            capacity_ = required;
+        }
+
+        rows_ = rows;
+        cols_ = cols;
+        stride_ = stride;
+
+        // дополнение строк должно содержать нули, чтобы векторные
+        // проходы по всей ширине строки не читали мусор
+        if (stride > cols)
+        {
+            for (size_t i = 0; i < rows; ++i)
+            {
+                std::memset(data_ + i * stride + cols, 0, (stride - cols) * sizeof(T));
+            }
+        }
+    }
+
+    T* operator[](const size_t i)
+    {
+        return data_ + i * stride_;
+    }
+
+    const T* operator[](const size_t i) const
+    {
+        return data_ + i * stride_;
+    }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t stride() const { return stride_; }
+
+    void swap(AlignedMatrix& other) noexcept
+    {
+        std::swap(data_, other.data_);
+        std::swap(rows_, other.rows_);
+        std::swap(cols_, other.cols_);
+        std::swap(stride_, other.stride_);
+        std::swap(capacity_, other.capacity_);
+    }
+
+private:
+    T* data_ = nullptr;
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    size_t stride_ = 0;
+    size_t capacity_ = 0;
+};
@@ -0,0 +1,418 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cilk/cilk_api.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+/// формат, в котором BenchmarkHarness печатает результаты замеров
+enum class ebenchmark_format
+{
+    csv = 0,
+    json
+};
+
+/// Структура BenchmarkOptions - параметры серии замеров
+struct BenchmarkOptions
+{
+    /// размеры задачи, передаваемые каждому замеру
+    std::vector<long long> sizes;
+    /// количества исполнителей Cilk Plus; для каждого среда выполнения перезапускается
+    std::vector<int> workers;
+    /// количество прогревочных и измеряемых запусков
+    int warmup = 2;
+    int repeats = 10;
+    /// закреплять ли процесс за workers физическими ядрами (SMT-соседи - только сверх их числа)
+    bool pin_threads = true;
+    ebenchmark_format format = ebenchmark_format::csv;
+    /// файл для результатов; nullptr - стандартный вывод
+    const char* output_path = nullptr;
+};
+
+/// Функция KeepResult() не дает компилятору удалить вычисление, результат которого
+/// замер иначе не использует: в GCC-совместимых компиляторах значение передается пустой
+/// ассемблерной вставке, в остальных - записывается в volatile-переменную и читается обратно
+inline void KeepResult(const double value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(value) : "memory");
+#else
+    static volatile double sink = 0.0;
+    sink = value;
+    static_cast<void>(sink);
+#endif
+}
+
+/// Структура ProcessAffinity - набор логических процессоров, на которых разрешено
+/// выполняться процессу
+struct ProcessAffinity
+{
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+#endif
+    /// удалось ли прочитать набор; если нет, процесс не закрепляется
+    bool valid = false;
+};
+
+/// Функция GetAffinity() возвращает текущий набор процессоров процесса
+inline ProcessAffinity GetAffinity()
+{
+    ProcessAffinity affinity;
+#ifdef _WIN32
+    DWORD_PTR system_mask = 0;
+    affinity.valid = GetProcessAffinityMask(GetCurrentProcess(), &affinity.mask, &system_mask) != 0;
+#elif defined(__linux__)
+    CPU_ZERO(&affinity.set);
+    affinity.valid = sched_getaffinity(0, sizeof(affinity.set), &affinity.set) == 0;
+#endif
+    return affinity;
+}
+
+/// Функция SetAffinity() восстанавливает набор процессоров, полученный GetAffinity()
+inline void SetAffinity(const ProcessAffinity& affinity)
+{
+    if (!affinity.valid)
+    {
+        return;
+    }
+#ifdef _WIN32
+    SetProcessAffinityMask(GetCurrentProcess(), affinity.mask);
+#elif defined(__linux__)
+    sched_setaffinity(0, sizeof(affinity.set), &affinity.set);
+#endif
+}
+
+#ifdef __linux__
+/// Функция ReadTopologyId() читает идентификатор name из /sys/devices/system/cpu/cpu<cpu>/topology;
+/// при ошибке возвращает -1
+inline long ReadTopologyId(const int cpu, const char* name)
+{
+    const std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + name;
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (file == nullptr)
+    {
+        return -1;
+    }
+    long id = -1;
+    if (std::fscanf(file, "%ld", &id) != 1)
+    {
+        id = -1;
+    }
+    std::fclose(file);
+    return id;
+}
+#endif
+
+/// Функция PhysicalCoreOrder() упорядочивает разрешенные в affinity логические процессоры
+/// так, что сначала идут по одному процессору каждого физического ядра, а затем их
+/// SMT-соседи (Hyper-Threading); если топологию узнать нельзя, каждый логический
+/// процессор считается отдельным ядром
+inline std::vector<int> PhysicalCoreOrder(const ProcessAffinity& affinity)
+{
+    std::vector<int> primary;
+    std::vector<int> siblings;
+#ifdef _WIN32
+    DWORD length = 0;
+    GetLogicalProcessorInformation(nullptr, &length);
+    std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+    if (info.empty() || !GetLogicalProcessorInformation(info.data(), &length))
+    {
+        info.clear();
+    }
+
+    const int bits = static_cast<int>(sizeof(DWORD_PTR) * 8);
+    DWORD_PTR covered = 0;
+    for (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION& entry : info)
+    {
+        if (entry.Relationship != RelationProcessorCore)
+        {
+            continue;
+        }
+        bool first = true;
+        for (int cpu = 0; cpu < bits; ++cpu)
+        {
+            const DWORD_PTR bit = static_cast<DWORD_PTR>(1) << cpu;
+            if ((entry.ProcessorMask & bit) != 0 && (affinity.mask & bit) != 0)
+            {
+                (first ? primary : siblings).push_back(cpu);
+                covered |= bit;
+                first = false;
+            }
+        }
+    }
+    for (int cpu = 0; cpu < bits; ++cpu)
+    {
+        const DWORD_PTR bit = static_cast<DWORD_PTR>(1) << cpu;
+        if ((affinity.mask & bit) != 0 && (covered & bit) == 0)
+        {
+            primary.push_back(cpu);
+        }
+    }
+    std::sort(primary.begin(), primary.end());
+#elif defined(__linux__)
+    std::vector<std::pair<long, long>> seen;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (!CPU_ISSET(cpu, &affinity.set))
+        {
+            continue;
+        }
+        const long package = ReadTopologyId(cpu, "physical_package_id");
+        const long core = ReadTopologyId(cpu, "core_id");
+        const std::pair<long, long> key = core < 0 ? std::make_pair(-1L - cpu, -1L) : std::make_pair(package, core);
+        if (std::find(seen.begin(), seen.end(), key) == seen.end())
+        {
+            seen.push_back(key);
+            primary.push_back(cpu);
+        }
+        else
+        {
+            siblings.push_back(cpu);
+        }
+    }
+#endif
+    primary.insert(primary.end(), siblings.begin(), siblings.end());
+    return primary;
+}
+
+/// Функция PinToCores() разрешает процессу выполняться только на первых count процессорах
+/// из order (см. PhysicalCoreOrder()): пока count не превышает числа физических ядер,
+/// каждый исполнитель получает собственное ядро, и лишь затем задействуются SMT-соседи.
+/// Потоки исполнителей Cilk Plus, создаваемые после вызова, наследуют это ограничение
+/// и не переходят на другие ядра и сокеты между запусками
+inline void PinToCores(const int count, const std::vector<int>& order)
+{
+    if (order.empty())
+    {
+        return;
+    }
+    const int used = std::min(std::max(count, 1), static_cast<int>(order.size()));
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (int i = 0; i < used; ++i)
+    {
+        mask |= static_cast<DWORD_PTR>(1) << order[i];
+    }
+    SetProcessAffinityMask(GetCurrentProcess(), mask);
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < used; ++i)
+    {
+        CPU_SET(order[i], &set);
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+#endif
+}
+
+/// Класс BenchmarkHarness - набор замеров, прогоняемых по всем размерам задачи
+/// и количествам исполнителей: после прогрева каждый замер запускается repeats раз,
+/// печатаются медиана, 95-й процентиль и минимум времени, параллельная эффективность
+/// относительно первого количества исполнителей из options.workers, а для замеров,
+/// зарегистрированных с Flops и Check, - также GFLOP/s и результат проверки
+class BenchmarkHarness
+{
+public:
+    /// подготовка данных для размера size, выполняется перед каждым запуском вне замера
+    using Prepare = std::function<void(long long size)>;
+    /// измеряемое тело
+    using Body = std::function<void(long long size)>;
+    /// количество операций с плавающей точкой в одном запуске размера size
+    using Flops = std::function<double(long long size)>;
+    /// проверка результата последнего запуска (например, относительная невязка),
+    /// выполняется вне замера
+    using Check = std::function<double(long long size)>;
+
+    /// Функция Add() регистрирует замер с именем name, для которого печатаются
+    /// GFLOP/s по flops и значение check (пустые функции - столбец не заполняется)
+    void Add(const std::string& name, Prepare prepare, Body body, Flops flops, Check check)
+    {
+        cases_.push_back({ name, std::move(prepare), std::move(body), std::move(flops), std::move(check) });
+    }
+
+    /// Функция Add() регистрирует замер с именем name
+    void Add(const std::string& name, Prepare prepare, Body body)
+    {
+        Add(name, std::move(prepare), std::move(body), Flops(), Check());
+    }
+
+    /// Функция Add() регистрирует замер без подготовки данных
+    void Add(const std::string& name, Body body)
+    {
+        Add(name, Prepare(), std::move(body));
+    }
+
+    /// Функция Run() выполняет все замеры и печатает результаты в формате options.format;
+    /// после серии процессу возвращается набор процессоров, действовавший до вызова
+    void Run(const BenchmarkOptions& options) const
+    {
+        const ProcessAffinity original = GetAffinity();
+        const std::vector<int> order = options.pin_threads && original.valid ? PhysicalCoreOrder(original) : std::vector<int>();
+
+        FILE* out = options.output_path != nullptr ? OpenOutput(options.output_path) : stdout;
+        if (out == nullptr)
+        {
+            out = stdout;
+        }
+
+        if (options.format == ebenchmark_format::csv)
+        {
+            std::fprintf(out, "case,size,workers,repeats,median_s,p95_s,min_s,gflops,efficiency,check\n");
+        }
+        else
+        {
+            std::fprintf(out, "[");
+        }
+
+        // медианы замеров при первом количестве исполнителей, по индексу замера и размеру
+        std::vector<std::vector<double>> base_median(cases_.size(), std::vector<double>(options.sizes.size(), 0.0));
+        const int base_workers = options.workers.empty() ? 1 : options.workers.front();
+
+        bool first_row = true;
+        for (const int workers : options.workers)
+        {
+            __cilkrts_end_cilk();
+            if (options.pin_threads)
+            {
+                PinToCores(workers, order);
+            }
+            __cilkrts_set_param("nworkers", std::to_string(workers).c_str());
+
+            for (size_t s = 0; s < options.sizes.size(); ++s)
+            {
+                const long long size = options.sizes[s];
+                for (size_t c = 0; c < cases_.size(); ++c)
+                {
+                    const Case& bench = cases_[c];
+                    const std::vector<double> times = Measure(bench, size, options);
+                    const double median = Percentile(times, 0.5);
+                    const double p95 = Percentile(times, 0.95);
+                    if (workers == base_workers)
+                    {
+                        base_median[c][s] = median;
+                    }
+                    const double efficiency = base_median[c][s] * base_workers / (static_cast<double>(workers) * median);
+
+                    const bool csv = options.format == ebenchmark_format::csv;
+                    const std::string gflops = bench.flops ? FormatValue("%.3f", bench.flops(size) / median * 1e-9) : std::string();
+                    const std::string check = bench.check ? FormatValue("%.3e", bench.check(size)) : std::string();
+
+                    if (csv)
+                    {
+                        std::fprintf(out, "%s,%lld,%d,%d,%.9f,%.9f,%.9f,%s,%.3f,%s\n", bench.name.c_str(), size, workers,
+                            static_cast<int>(times.size()), median, p95, times.front(), gflops.c_str(), efficiency,
+                            check.c_str());
+                    }
+                    else
+                    {
+                        std::fprintf(out, "%s\n  {\"case\": \"%s\", \"size\": %lld, \"workers\": %d, \"repeats\": %d, "
+                            "\"median_s\": %.9f, \"p95_s\": %.9f, \"min_s\": %.9f, \"gflops\": %s, \"efficiency\": %.3f, "
+                            "\"check\": %s}", first_row ? "" : ",", bench.name.c_str(), size, workers,
+                            static_cast<int>(times.size()), median, p95, times.front(),
+                            gflops.empty() ? "null" : gflops.c_str(), efficiency, check.empty() ? "null" : check.c_str());
+                    }
+                    first_row = false;
+                    std::fflush(out);
+                }
+            }
+        }
+
+        if (options.format == ebenchmark_format::json)
+        {
+            std::fprintf(out, "\n]\n");
+        }
+        if (out != stdout)
+        {
+            std::fclose(out);
+        }
+
+        __cilkrts_end_cilk();
+        if (options.pin_threads)
+        {
+            SetAffinity(original);
+        }
+    }
+
+private:
+    struct Case
+    {
+        std::string name;
+        Prepare prepare;
+        Body body;
+        Flops flops;
+        Check check;
+    };
+
+    /// Функция FormatValue() печатает value по формату format в строку
+    static std::string FormatValue(const char* format, const double value)
+    {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), format, value);
+        return buffer;
+    }
+
+    /// Функция OpenOutput() открывает файл результатов на запись; при ошибке возвращает nullptr
+    static FILE* OpenOutput(const char* path)
+    {
+#ifdef _MSC_VER
+        FILE* file = nullptr;
+        return fopen_s(&file, path, "w") == 0 ? file : nullptr;
+#else
+        return std::fopen(path, "w");
+#endif
+    }
+
+    /// Функция Measure() возвращает отсортированные времена repeats (не меньше одного)
+    /// запусков после warmup прогревочных
+    static std::vector<double> Measure(const Case& bench, const long long size, const BenchmarkOptions& options)
+    {
+        const int repeats = std::max(options.repeats, 1);
+        std::vector<double> times;
+        times.reserve(repeats);
+
+        for (int run = 0; run < options.warmup + repeats; ++run)
+        {
+            if (bench.prepare)
+            {
+                bench.prepare(size);
+            }
+
+            const std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            bench.body(size);
+            const std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+            if (run >= options.warmup)
+            {
+                times.push_back(std::chrono::duration<double>(t2 - t1).count());
+            }
+        }
+
+        std::sort(times.begin(), times.end());
+        return times;
+    }
+
+    /// Функция Percentile() - значение отсортированной выборки с долей fraction (по ближайшему рангу)
+    static double Percentile(const std::vector<double>& sorted, const double fraction)
+    {
+        const size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+        return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+    }
+
+    std::vector<Case> cases_;
+};
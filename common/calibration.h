@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+
+#include "benchmark.h"
+
+/// Функция MinCallTime() возвращает наименьшее из repeats времен вызова call;
+/// результат вызова передается KeepResult(), чтобы компилятор не удалил пробный запуск
+template <typename Call>
+double MinCallTime(const Call& call, const int repeats)
+{
+    double best = DBL_MAX;
+    for (int i = 0; i < repeats; ++i)
+    {
+        const std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        KeepResult(call());
+        const std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double>(t2 - t1).count());
+    }
+    return best;
+}
+
+/// Функция MeasureCutoff() перебирает размеры first, 2 * first, ... не больше last
+/// и возвращает наименьший, начиная с которого parallel_wins(size) выполняется
+/// на двух размерах подряд, чтобы случайный выброс времени на малом размере
+/// не сдвинул порог вниз; если такого размера нет, возвращает INT_MAX
+template <typename Wins>
+int MeasureCutoff(const int first, const int last, const Wins& parallel_wins)
+{
+    int first_win = 0;
+    for (int size = first; size <= last; size *= 2)
+    {
+        if (!parallel_wins(size))
+        {
+            first_win = 0;
+            continue;
+        }
+
+        if (first_win != 0)
+        {
+            return first_win;
+        }
+        first_win = size;
+    }
+    return INT_MAX;
+}
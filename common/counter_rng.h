@@ -0,0 +1,103 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cilk/cilk.h>
+
+/// количество элементов, заполняемых одной задачей в ParallelFillUniformInt()
+constexpr long long RNG_FILL_BLOCK = 1 << 14;
+
+/// Класс PhiloxRng - счетчиковый генератор псевдослучайных чисел Philox4x32-10:
+/// число с номером index зависит только от seed и index, поэтому массив можно
+/// заполнять параллельно в любом порядке, и результат не зависит от числа исполнителей.
+/// Общего изменяемого состояния нет, объект можно использовать из любых потоков
+class PhiloxRng
+{
+public:
+    explicit PhiloxRng(const unsigned long long seed)
+    {
+        key_[0] = static_cast<std::uint32_t>(seed);
+        key_[1] = static_cast<std::uint32_t>(seed >> 32);
+    }
+
+    /// Функция Block() вычисляет четыре 32-битных числа с номерами 4*block .. 4*block+3
+    void Block(const unsigned long long block, std::uint32_t out[4]) const
+    {
+        std::uint32_t c0 = static_cast<std::uint32_t>(block);
+        std::uint32_t c1 = static_cast<std::uint32_t>(block >> 32);
+        std::uint32_t c2 = 0;
+        std::uint32_t c3 = 0;
+        std::uint32_t k0 = key_[0];
+        std::uint32_t k1 = key_[1];
+
+        for (int round = 0; round < 10; ++round)
+        {
+            const std::uint64_t p0 = static_cast<std::uint64_t>(0xD2511F53u) * c0;
+            const std::uint64_t p1 = static_cast<std::uint64_t>(0xCD9E8D57u) * c2;
+            c0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            c1 = static_cast<std::uint32_t>(p1);
+            c2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3 ^ k1;
+            c3 = static_cast<std::uint32_t>(p0);
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+    /// Функция operator() возвращает 32-битное число с номером index
+    std::uint32_t operator()(const unsigned long long index) const
+    {
+        std::uint32_t words[4];
+        Block(index / 4, words);
+        return words[index % 4];
+    }
+
+    /// Функция UniformInt() возвращает число с номером index, приведенное к отрезку [low, high]
+    int UniformInt(const unsigned long long index, const int low, const int high) const
+    {
+        return ToRange((*this)(index), low, high);
+    }
+
+    /// Функция ToRange() приводит 32-битное число к отрезку [low, high] умножением со сдвигом
+    static int ToRange(const std::uint32_t word, const int low, const int high)
+    {
+        const std::uint64_t range = static_cast<std::uint64_t>(static_cast<std::int64_t>(high) - low + 1);
+        return static_cast<int>(low + static_cast<std::int64_t>((word * range) >> 32));
+    }
+
+private:
+    std::uint32_t key_[2];
+};
+
+/// Функция FillUniformInt() последовательно заполняет count элементов массива data
+/// числами генератора rng с номерами first_index .. first_index+count-1 из отрезка [low, high]
+template <typename T>
+void FillUniformInt(T* data, const long long first_index, const long long count, const PhiloxRng& rng,
+    const int low, const int high)
+{
+    std::uint32_t words[4];
+    for (long long k = first_index; k < first_index + count; ++k)
+    {
+        if (k == first_index || k % 4 == 0)
+        {
+            rng.Block(k / 4, words);
+        }
+        data[k - first_index] = static_cast<T>(PhiloxRng::ToRange(words[k % 4], low, high));
+    }
+}
+
+/// Функция ParallelFillUniformInt() заполняет массив data из count элементов числами
+/// из отрезка [low, high]: элемент i получает число генератора rng с номером i,
+/// блоки по RNG_FILL_BLOCK элементов заполняются параллельно
+template <typename T>
+void ParallelFillUniformInt(T* data, const long long count, const PhiloxRng& rng, const int low, const int high)
+{
+    cilk_for (long long first = 0; first < count; first += RNG_FILL_BLOCK)
+    {
+        FillUniformInt(data + first, first, count - first < RNG_FILL_BLOCK ? count - first : RNG_FILL_BLOCK,
+            rng, low, high);
+    }
+}
@@ -0,0 +1,185 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <cilk/cilk.h>
+
+/// количество слагаемых в блоке детерминированной суммы: форма разбиения
+/// зависит только от количества слагаемых, но не от числа исполнителей
+constexpr long long DETERMINISTIC_SUM_BLOCK = 4096;
+/// количество независимых компенсированных сумм внутри блока (ширина SIMD-цикла)
+constexpr int COMPENSATED_LANES = 8;
+/// наибольшее количество блоков, частичные суммы которых DeterministicReduce()
+/// держит в массиве на стеке, а не в выделяемом векторе
+constexpr long long DETERMINISTIC_STACK_BLOCKS = 64;
+
+// компенсация погрешности держится на порядке операций с плавающей точкой,
+// поэтому код ниже собирается без переупорядочивания (даже при /fp:fast)
+#ifdef _MSC_VER
+#pragma float_control(precise, on, push)
+#endif
+
+/// Класс NeumaierSum - сумма с компенсацией ошибок округления по алгоритму Ноймайера:
+/// потерянные при сложении младшие разряды копятся в отдельной поправке
+class NeumaierSum
+{
+public:
+    NeumaierSum(const double sum = 0.0, const double compensation = 0.0)
+        : sum_(sum), compensation_(compensation)
+    {
+    }
+
+    void add(const double value)
+    {
+        const double t = sum_ + value;
+        compensation_ += std::fabs(sum_) >= std::fabs(value) ? (sum_ - t) + value : (value - t) + sum_;
+        sum_ = t;
+    }
+
+    void add(const NeumaierSum& other)
+    {
+        add(other.sum_);
+        compensation_ += other.compensation_;
+    }
+
+    double value() const
+    {
+        return sum_ + compensation_;
+    }
+
+private:
+    double sum_;
+    double compensation_;
+};
+
+/// Функция CompensatedSum() последовательно суммирует term(i), i = first..last-1:
+/// слагаемые раскладываются по COMPENSATED_LANES суммам Ноймайера, которые
+/// обновляются одним векторизуемым циклом и складываются в конце в фиксированном порядке
+template <typename Term>
+NeumaierSum CompensatedSum(const long long first, const long long last, const Term& term)
+{
+    double sums[COMPENSATED_LANES] = {};
+    double compensations[COMPENSATED_LANES] = {};
+
+    long long i = first;
+    for (; i + COMPENSATED_LANES <= last; i += COMPENSATED_LANES)
+    {
+#pragma omp simd
+        for (int lane = 0; lane < COMPENSATED_LANES; ++lane)
+        {
+            const double value = term(i + lane);
+            const double t = sums[lane] + value;
+            compensations[lane] += std::fabs(sums[lane]) >= std::fabs(value) ? (sums[lane] - t) + value
+                                                                            : (value - t) + sums[lane];
+            sums[lane] = t;
+        }
+    }
+
+    NeumaierSum res;
+    for (int lane = 0; lane < COMPENSATED_LANES; ++lane)
+    {
+        res.add(NeumaierSum(sums[lane], compensations[lane]));
+    }
+    for (; i < last; ++i)
+    {
+        res.add(term(i));
+    }
+    return res;
+}
+
+/// Функция CompensatedAdd() прибавляет values[j] к суммам Ноймайера с составляющими
+/// sums[j] и compensations[j], j = 0..count-1: так одним векторизуемым проходом
+/// по строке матрицы накапливаются суммы всех ее столбцов
+inline void CompensatedAdd(double* sums, double* compensations, const double* values, const size_t count)
+{
+#pragma omp simd
+    for (size_t j = 0; j < count; ++j)
+    {
+        const double t = sums[j] + values[j];
+        compensations[j] += std::fabs(sums[j]) >= std::fabs(values[j]) ? (sums[j] - t) + values[j]
+                                                                        : (values[j] - t) + sums[j];
+        sums[j] = t;
+    }
+}
+
+/// Функция CompensatedAdd() прибавляет к суммам Ноймайера (sums[j], compensations[j])
+/// другие суммы (other_sums[j], other_compensations[j]), j = 0..count-1,
+/// так же, как NeumaierSum::add() прибавляет одну сумму к другой
+inline void CompensatedAdd(double* sums, double* compensations, const double* other_sums,
+                           const double* other_compensations, const size_t count)
+{
+    CompensatedAdd(sums, compensations, other_sums, count);
+
+#pragma omp simd
+    for (size_t j = 0; j < count; ++j)
+    {
+        compensations[j] += other_compensations[j];
+    }
+}
+
+/// Функция PairwiseCombine() складывает count частичных сумм попарным деревом,
+/// форма которого зависит только от count
+inline NeumaierSum PairwiseCombine(const NeumaierSum* partials, const long long count)
+{
+    if (count == 1)
+    {
+        return partials[0];
+    }
+
+    const long long half = count / 2;
+    NeumaierSum res = PairwiseCombine(partials, half);
+    res.add(PairwiseCombine(partials + half, count - half));
+    return res;
+}
+
+/// Функция DeterministicReduce() складывает результаты block_sum(b), b = 0..block_count-1
+/// (double или NeumaierSum): блоки вычисляются параллельно, по grain блоков на задачу,
+/// а их суммы объединяются попарным деревом с компенсацией. Результат побитово
+/// одинаков при любом количестве исполнителей и порядке кражи задач,
+/// если block_sum сама не зависит от них. Единственный блок считается без cilk_for,
+/// а память под частичные суммы выделяется, только если блоков больше DETERMINISTIC_STACK_BLOCKS
+template <typename BlockSum>
+double DeterministicReduce(const long long block_count, const BlockSum& block_sum, const long long grain = 1)
+{
+    if (block_count <= 0)
+    {
+        return 0.0;
+    }
+    if (block_count == 1)
+    {
+        return NeumaierSum(block_sum(0)).value();
+    }
+
+    NeumaierSum stack_partials[DETERMINISTIC_STACK_BLOCKS];
+    std::vector<NeumaierSum> heap_partials;
+    NeumaierSum* partials = stack_partials;
+    if (block_count > DETERMINISTIC_STACK_BLOCKS)
+    {
+        heap_partials.resize(block_count);
+        partials = heap_partials.data();
+    }
+
+#pragma cilk grainsize = grain
+    cilk_for (long long b = 0; b < block_count; ++b)
+    {
+        partials[b] = NeumaierSum(block_sum(b));
+    }
+
+    return PairwiseCombine(partials, block_count).value();
+}
+
+/// Функция DeterministicSum() - детерминированная компенсированная сумма term(i), i = 0..n-1,
+/// по блокам из DETERMINISTIC_SUM_BLOCK слагаемых
+template <typename Term>
+double DeterministicSum(const long long n, const Term& term)
+{
+    return DeterministicReduce((n + DETERMINISTIC_SUM_BLOCK - 1) / DETERMINISTIC_SUM_BLOCK, [&](const long long b)
+    {
+        return CompensatedSum(b * DETERMINISTIC_SUM_BLOCK, std::min((b + 1) * DETERMINISTIC_SUM_BLOCK, n), term);
+    });
+}
+
+#ifdef _MSC_VER
+#pragma float_control(pop)
+#endif
@@ -0,0 +1,50 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <cilk/cilk.h>
+
+/// количество индексов, обрабатываемых одной задачей в ParallelAppendIf()
+constexpr long long PARALLEL_FILL_BLOCK = 1 << 14;
+
+/// Функция ParallelAppendIf() дописывает в конец out те из значений generator(i),
+/// i = 0..count-1, для которых keep(значение) истинно, сохраняя порядок i.
+/// Каждый блок из PARALLEL_FILL_BLOCK индексов собирает подходящие значения в свой
+/// буфер, префиксная сумма размеров буферов дает их места в out, после чего out
+/// увеличивается один раз и буферы параллельно копируются на свои места
+template <typename T, typename Generator, typename Predicate>
+void ParallelAppendIf(std::vector<T>& out, const long long count, const Generator& generator, const Predicate& keep)
+{
+    const long long blocks = (count + PARALLEL_FILL_BLOCK - 1) / PARALLEL_FILL_BLOCK;
+    std::vector<std::vector<T>> chunks(blocks);
+
+    cilk_for (long long b = 0; b < blocks; ++b)
+    {
+        const long long last = std::min((b + 1) * PARALLEL_FILL_BLOCK, count);
+        std::vector<T>& chunk = chunks[b];
+        chunk.reserve(last - b * PARALLEL_FILL_BLOCK);
+        for (long long i = b * PARALLEL_FILL_BLOCK; i < last; ++i)
+        {
+            T value = generator(i);
+            if (keep(value))
+            {
+                chunk.push_back(value);
+            }
+        }
+    }
+
+    // offsets[b] - позиция первого значения блока b в out
+    std::vector<size_t> offsets(blocks + 1);
+    offsets[0] = out.size();
+    for (long long b = 0; b < blocks; ++b)
+    {
+        offsets[b + 1] = offsets[b] + chunks[b].size();
+    }
+
+    out.resize(offsets[blocks]);
+
+    cilk_for (long long b = 0; b < blocks; ++b)
+    {
+        std::copy(chunks[b].begin(), chunks[b].end(), out.begin() + offsets[b]);
+    }
+}
@@ -1,34 +1,201 @@
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <stdio.h>
+#include <cmath>
+#include <functional>
+#include <fstream>
+#include <climits>
+#include <map>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <random>
+#include <immintrin.h>
 #include <cilk/cilk_api.h>
 #include <cilk/cilk.h>
-#include <cilk/reducer_opadd.h>
 
 #include <chrono>
 
+#include "../../common/benchmark.h"
+#include "../../common/calibration.h"
+#include "../../common/deterministic_sum.h"
+
 #define ITERATIONS 1000
+//      ;  
+// (    )    
+#define GRAIN_POINTS 1024
+//  :       
+//   ,      
+#define ADAPTIVE_MAX_DEPTH 50
+#define ADAPTIVE_SPAWN_LEVELS 10
+//  ,       evaluate()
+#define EVAL_BLOCK 256
+//    :   ,
+//           
+#define CALIBRATION_FILE "integration_tuning.txt"
+#define CALIBRATION_MAX_POINTS (1 << 18)
+#define CALIBRATION_REPEATS 5
+//    -:    
+// (          ),
+//       
+//         
+#define MC_BLOCK_POINTS 4096
+#define QMC_REPLICATES 8
+#define QMC_MAX_DIMENSIONS 12
+//  :      
+// BenchmarkHarness    ()   ,  - CSV
+#define MICROBENCHMARK_MODE 0
+
+///  ,     (  );
+///           
+using Integrand = std::function<double(double)>;
 
 namespace
 {
     std::chrono::duration<double> duration_s{0.0};
     std::chrono::duration<double> duration_p{ 0.0 };
+    std::chrono::duration<double> duration_a{ 0.0 };
 }
 
 
-double CalcIntegral(double beg, double end, std::function<double(double)> func, int N = 10)
+///   ,  operator()(double),  
+///     void evaluate(const double* x, double* y, int count) const,
+///     count .    
+///    EVAL_BLOCK      
+template <typename Func, typename = void>
+struct has_batch_evaluate : std::false_type {};
+
+template <typename Func>
+struct has_batch_evaluate<Func, decltype(std::declval<const Func&>().evaluate(
+    std::declval<const double*>(), std::declval<double*>(), 0))> : std::true_type {};
+
+
+///  InverseSqrtFunction -   a / sqrt(b - c*x*x);
+///     8 (AVX-512), 4 (AVX)  2 (SSE2)   
+struct InverseSqrtFunction
+{
+    double a;
+    double b;
+    double c;
+
+    double operator()(double x) const
+    {
+        return a / std::sqrt(b - c*x*x);
+    }
+
+    void evaluate(const double* x, double* y, int count) const
+    {
+        int i = 0;
+#if defined(__AVX512F__)
+        const __m512d va = _mm512_set1_pd(a);
+        const __m512d vb = _mm512_set1_pd(b);
+        const __m512d vc = _mm512_set1_pd(c);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m512d vx = _mm512_loadu_pd(x + i);
+            __m512d vd = _mm512_sub_pd(vb, _mm512_mul_pd(vc, _mm512_mul_pd(vx, vx)));
+            _mm512_storeu_pd(y + i, _mm512_div_pd(va, _mm512_sqrt_pd(vd)));
+        }
+#elif defined(__AVX__)
+        const __m256d va = _mm256_set1_pd(a);
+        const __m256d vb = _mm256_set1_pd(b);
+        const __m256d vc = _mm256_set1_pd(c);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m256d vx = _mm256_loadu_pd(x + i);
+            __m256d vd = _mm256_sub_pd(vb, _mm256_mul_pd(vc, _mm256_mul_pd(vx, vx)));
+            _mm256_storeu_pd(y + i, _mm256_div_pd(va, _mm256_sqrt_pd(vd)));
+        }
+#else
+        const __m128d va = _mm_set1_pd(a);
+        const __m128d vb = _mm_set1_pd(b);
+        const __m128d vc = _mm_set1_pd(c);
+        for (; i + 2 <= count; i += 2)
+        {
+            __m128d vx = _mm_loadu_pd(x + i);
+            __m128d vd = _mm_sub_pd(vb, _mm_mul_pd(vc, _mm_mul_pd(vx, vx)));
+            _mm_storeu_pd(y + i, _mm_div_pd(va, _mm_sqrt_pd(vd)));
+        }
+#endif
+        for (; i < count; ++i)
+            y[i] = (*this)(x[i]);
+    }
+};
+
+
+///  :    ,   
+template <typename Func>
+inline double SumPoints(const double beg, const double h, const Func& func, const int first, const int last,
+    std::false_type)
 {
     double res = 0.0;
-    double h = (end - beg) / N;
-    double x = 0.;
 
-    for (int i = 0; i <= N; ++i)
+#pragma omp simd reduction(+:res)
+    for (int i = first; i <= last; ++i)
         res += func(beg + i*h);
 
     return res;
 }
 
 
-double SerialShell(double beg, double end, std::function<double(double)> func, int N = 10)
+///  :      EVAL_BLOCK   evaluate()
+template <typename Func>
+inline double SumPoints(const double beg, const double h, const Func& func, const int first, const int last,
+    std::true_type)
+{
+    double x[EVAL_BLOCK];
+    double y[EVAL_BLOCK];
+    double res = 0.0;
+
+    for (int block = first; block <= last; block += EVAL_BLOCK)
+    {
+        const int count = std::min(EVAL_BLOCK, last - block + 1);
+
+#pragma omp simd
+        for (int i = 0; i < count; ++i)
+            x[i] = beg + (block + i)*h;
+
+        func.evaluate(x, y, count);
+
+#pragma omp simd reduction(+:res)
+        for (int i = 0; i < count; ++i)
+            res += y[i];
+    }
+
+    return res;
+}
+
+
+///  SumPoints()   func   beg + i*h, i = first..last;
+///  func    ,    
+template <typename Func>
+inline double SumPoints(const double beg, const double h, const Func& func, const int first, const int last)
+{
+    return SumPoints(beg, h, func, first, last, has_batch_evaluate<Func>());
+}
+
+
+///  CalcIntegral()       N 
+template <typename Func>
+double CalcIntegral(double beg, double end, const Func& func, int N = 10)
+{
+    double h = (end - beg) / N;
+    double res = SumPoints(beg, h, func, 0, N);
+
+    //       h/2,   - h
+    return (res - 0.5 * (func(beg) + func(end))) * h;
+}
+
+
+double CalcIntegral(double beg, double end, const Integrand& func, int N = 10)
+{
+    return CalcIntegral<Integrand>(beg, end, func, N);
+}
+
+
+template <typename Func>
+double SerialShell(double beg, double end, const Func& func, int N = 10)
 {
     std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
     double res = 0;
@@ -42,22 +209,40 @@ double SerialShell(double beg, double end, std::function<double(double)> func, i
 }
 
 
-double CalcIntegral_paralel(double beg, double end, std::function<double(double)> func, int N = 10)
+///  :     
+///  GRAIN_POINTS,     , 
+///      ; grain -  
+///    (    )
+template <typename Func>
+double CalcIntegral_paralel(double beg, double end, const Func& func, int N, int grain)
 {
-    cilk::reducer_opadd<double> res(0.0);
     double h = (end - beg) / N;
-    double x = 0.;
 
-    cilk_for(int i = 0; i <= N; ++i)
+    double res = DeterministicReduce(N / GRAIN_POINTS + 1, [&](const long long block)
     {
-        res += func(beg + i*h);
-    }
+        const int first = static_cast<int>(block) * GRAIN_POINTS;
+        return SumPoints(beg, h, func, first, std::min(first + GRAIN_POINTS - 1, N));
+    }, std::max(1, grain / GRAIN_POINTS));
+
+    return (res - 0.5 * (func(beg) + func(end))) * h;
+}
+
+
+template <typename Func>
+double CalcIntegral_paralel(double beg, double end, const Func& func, int N = 10)
+{
+    return CalcIntegral_paralel(beg, end, func, N, GRAIN_POINTS);
+}
 
-    return res.get_value();
+
+double CalcIntegral_paralel(double beg, double end, const Integrand& func, int N = 10)
+{
+    return CalcIntegral_paralel<Integrand>(beg, end, func, N);
 }
 
 
-double ParalelShell(double beg, double end, std::function<double(double)> func, int N = 10)
+template <typename Func>
+double ParalelShell(double beg, double end, const Func& func, int N = 10)
 {
     std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
     double res = 0;
@@ -71,27 +256,706 @@ double ParalelShell(double beg, double end, std::function<double(double)> func,
 }
 
 
+///  IntegrationTuning -      
+/// :  ,    , 
+///  ,     ,    
+struct IntegrationTuning
+{
+    int workers;
+    int parallel_cutoff;
+    int grain_points;
+};
+
+
+///  CalibrateIntegration()      
+/// :      CALIBRATION_MAX_POINTS , 
+///    ( ),     
+///     
+IntegrationTuning CalibrateIntegration(const int workers)
+{
+    IntegrationTuning tuning = { workers, INT_MAX, GRAIN_POINTS };
+    if (workers < 2)
+        return tuning;
+
+    const InverseSqrtFunction func = { 5., 8., 4. };
+    const int grains[] = { GRAIN_POINTS, 4 * GRAIN_POINTS, 16 * GRAIN_POINTS, 64 * GRAIN_POINTS };
+    double best_time = 0.0;
+
+    for (int grain : grains)
+    {
+        const double time = MinCallTime([&] { return CalcIntegral_paralel(-1., 1., func, CALIBRATION_MAX_POINTS, grain); },
+            CALIBRATION_REPEATS);
+        if (grain == grains[0] || time < best_time)
+        {
+            best_time = time;
+            tuning.grain_points = grain;
+        }
+    }
+
+    tuning.parallel_cutoff = MeasureCutoff(64, CALIBRATION_MAX_POINTS, [&](const int N)
+    {
+        const double serial_time = MinCallTime([&] { return CalcIntegral(-1., 1., func, N); }, CALIBRATION_REPEATS);
+        const double paralel_time = MinCallTime([&] { return CalcIntegral_paralel(-1., 1., func, N, tuning.grain_points); },
+            CALIBRATION_REPEATS);
+        return paralel_time < serial_time;
+    });
+
+    return tuning;
+}
+
+
+///  LoadIntegrationTuning()    workers .
+///      CALIBRATION_FILE      
+///  (   );   workers  ,
+///         .
+///      ,      
+const IntegrationTuning& LoadIntegrationTuning(const int workers)
+{
+    static std::mutex tunings_mutex;
+    static std::map<int, IntegrationTuning> tunings;
+    static bool loaded = false;
+
+    std::lock_guard<std::mutex> lock(tunings_mutex);
+
+    if (!loaded)
+    {
+        loaded = true;
+        std::ifstream in(CALIBRATION_FILE);
+        IntegrationTuning cached = { 0, 0, 0 };
+        while (in >> cached.workers >> cached.parallel_cutoff >> cached.grain_points)
+        {
+            if (cached.workers > 0 && cached.parallel_cutoff > 0 && cached.grain_points > 0)
+                tunings[cached.workers] = cached;
+        }
+    }
+
+    const auto found = tunings.find(workers);
+    if (found != tunings.end())
+        return found->second;
+
+    const IntegrationTuning& calibrated = tunings[workers] = CalibrateIntegration(workers);
+
+    std::ofstream out(CALIBRATION_FILE);
+    for (const auto& entry : tunings)
+    {
+        const IntegrationTuning& tuning = entry.second;
+        out << tuning.workers << ' ' << tuning.parallel_cutoff << ' ' << tuning.grain_points << '\n';
+    }
+    return calibrated;
+}
+
+
+///  GetIntegrationTuning()      .
+///    ,      ,
+///        LoadIntegrationTuning()
+const IntegrationTuning& GetIntegrationTuning()
+{
+    static std::atomic<const IntegrationTuning*> last(nullptr);
+
+    const int workers = __cilkrts_get_nworkers();
+    const IntegrationTuning* tuning = last.load(std::memory_order_acquire);
+    if (tuning == nullptr || tuning->workers != workers)
+    {
+        tuning = &LoadIntegrationTuning(workers);
+        last.store(tuning, std::memory_order_release);
+    }
+    return *tuning;
+}
+
+
+///  CalcIntegral_auto()      
+///         
+template <typename Func>
+double CalcIntegral_auto(double beg, double end, const Func& func, int N = 10)
+{
+    const IntegrationTuning& tuning = GetIntegrationTuning();
+    if (N < tuning.parallel_cutoff)
+        return CalcIntegral(beg, end, func, N);
+
+    return CalcIntegral_paralel(beg, end, func, N, tuning.grain_points);
+}
+
+
+double CalcIntegral_auto(double beg, double end, const Integrand& func, int N = 10)
+{
+    return CalcIntegral_auto<Integrand>(beg, end, func, N);
+}
+
+
+template <typename Func>
+double AutoShell(double beg, double end, const Func& func, int N = 10)
+{
+    std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+    double res = 0;
+    for (int i = 0; i < ITERATIONS; ++i)
+        res = CalcIntegral_auto(beg, end, func, N);
+
+    std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+    duration_a = (t2 - t1);
+
+    return res;
+}
+
+
+///  IntegrationJob -    :
+/// ,      
+template <typename Func = Integrand>
+struct IntegrationJob
+{
+    double beg;
+    double end;
+    Func func;
+    int N;
+};
+
+
+///  CalcIntegralBatch()       .
+///          ,     
+///   cilk_for,      ,
+///    .       
+///      .
+///      
+template <typename Func>
+std::vector<double> CalcIntegralBatch(const std::vector<IntegrationJob<Func>>& jobs)
+{
+    const int job_count = static_cast<int>(jobs.size());
+    const int grain = GetIntegrationTuning().grain_points;
+
+    // first_block[j] -     j
+    std::vector<int> first_block(job_count + 1, 0);
+    for (int j = 0; j < job_count; ++j)
+    {
+        first_block[j + 1] = first_block[j] + jobs[j].N / grain + 1;
+    }
+
+    std::vector<double> partial(first_block[job_count]);
+
+    cilk_for(int block = 0; block < first_block[job_count]; ++block)
+    {
+        const int j = static_cast<int>(std::upper_bound(first_block.begin(), first_block.end(), block) - first_block.begin()) - 1;
+        const IntegrationJob<Func>& job = jobs[j];
+        const double h = (job.end - job.beg) / job.N;
+        const int first = (block - first_block[j]) * grain;
+
+        partial[block] = SumPoints(job.beg, h, job.func, first, std::min(first + grain - 1, job.N));
+    }
+
+    std::vector<double> results(job_count);
+
+    cilk_for(int j = 0; j < job_count; ++j)
+    {
+        const IntegrationJob<Func>& job = jobs[j];
+        const double h = (job.end - job.beg) / job.N;
+        double res = 0.0;
+
+        for (int block = first_block[j]; block < first_block[j + 1]; ++block)
+            res += partial[block];
+
+        results[j] = (res - 0.5 * (job.func(job.beg) + job.func(job.end))) * h;
+    }
+
+    return results;
+}
+
+
+///  IntegralResult -  ,   
+///     
+struct IntegralResult
+{
+    double value;
+    double error;
+    long evaluations;
+};
+
+
+///  AdaptiveSimpsonStep()     [a, b],  
+///              whole:
+///   ,        tolerance.
+///   ADAPTIVE_SPAWN_LEVELS     .
+template <typename Func>
+IntegralResult AdaptiveSimpsonStep(const Func& func, double a, double b, double fa, double fm, double fb,
+    double whole, double tolerance, int level)
+{
+    double m = 0.5 * (a + b);
+    double lm = 0.5 * (a + m);
+    double rm = 0.5 * (m + b);
+    double flm = func(lm);
+    double frm = func(rm);
+
+    double left = (m - a) / 6. * (fa + 4. * flm + fm);
+    double right = (b - m) / 6. * (fm + 4. * frm + fb);
+    double delta = left + right - whole;
+
+    if (level >= ADAPTIVE_MAX_DEPTH || std::fabs(delta) <= 15. * tolerance)
+    {
+        //        
+        return { left + right + delta / 15., std::fabs(delta) / 15., 2 };
+    }
+
+    IntegralResult res_left;
+    IntegralResult res_right;
+    if (level < ADAPTIVE_SPAWN_LEVELS)
+    {
+        res_left = cilk_spawn AdaptiveSimpsonStep(func, a, m, fa, flm, fm, left, 0.5 * tolerance, level + 1);
+        res_right = AdaptiveSimpsonStep(func, m, b, fm, frm, fb, right, 0.5 * tolerance, level + 1);
+        cilk_sync;
+    }
+    else
+    {
+        res_left = AdaptiveSimpsonStep(func, a, m, fa, flm, fm, left, 0.5 * tolerance, level + 1);
+        res_right = AdaptiveSimpsonStep(func, m, b, fm, frm, fb, right, 0.5 * tolerance, level + 1);
+    }
+
+    return { res_left.value + res_right.value, res_left.error + res_right.error,
+             res_left.evaluations + res_right.evaluations + 2 };
+}
+
+
+///  CalcIntegral_adaptive()     
+///     tolerance:    ,
+///     
+template <typename Func>
+IntegralResult CalcIntegral_adaptive(double beg, double end, const Func& func, double tolerance)
+{
+    double fa = func(beg);
+    double fm = func(0.5 * (beg + end));
+    double fb = func(end);
+    double whole = (end - beg) / 6. * (fa + 4. * fm + fb);
+
+    IntegralResult res = AdaptiveSimpsonStep(func, beg, end, fa, fm, fb, whole, tolerance, 0);
+    res.evaluations += 3;
+    return res;
+}
+
+
+IntegralResult CalcIntegral_adaptive(double beg, double end, const Integrand& func, double tolerance)
+{
+    return CalcIntegral_adaptive<Integrand>(beg, end, func, tolerance);
+}
+
+
+///       -
+enum class esampling
+{
+    pseudo_random,
+    halton,
+    sobol
+};
+
+
+///  SplitMix64()   x;   
+///      seed   
+inline unsigned long long SplitMix64(unsigned long long x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+
+///  ToUnitInterval()  64      [0, 1)
+inline double ToUnitInterval(unsigned long long bits)
+{
+    return (bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+///  RadicalInverse() - index-        base
+inline double RadicalInverse(unsigned long long index, unsigned base)
+{
+    const double inv_base = 1.0 / base;
+    double factor = inv_base;
+    double res = 0.0;
+    for (; index != 0; index /= base, factor *= inv_base)
+        res += (index % base) * factor;
+    return res;
+}
+
+
+///  Primes() -      
+inline const unsigned* Primes()
+{
+    static const unsigned primes[QMC_MAX_DIMENSIONS] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+    return primes;
+}
+
+
+///  SobolDirections()     
+/// ( 32  ,   - )   dim 
+void SobolDirections(int dim, std::vector<unsigned>& directions)
+{
+    //   ,     m_k
+    struct SobolPolynomial
+    {
+        int degree;
+        unsigned a;
+        unsigned m[5];
+    };
+    static const SobolPolynomial polynomials[QMC_MAX_DIMENSIONS - 1] = {
+        { 1, 0, { 1 } }, { 2, 1, { 1, 3 } }, { 3, 1, { 1, 3, 1 } }, { 3, 2, { 1, 1, 1 } },
+        { 4, 1, { 1, 1, 3, 3 } }, { 4, 4, { 1, 3, 5, 13 } }, { 5, 2, { 1, 1, 5, 5, 17 } },
+        { 5, 4, { 1, 1, 5, 5, 5 } }, { 5, 7, { 1, 1, 7, 11, 19 } }, { 5, 11, { 1, 1, 5, 1, 1 } },
+        { 5, 13, { 1, 1, 1, 3, 11 } }
+    };
+
+    directions.assign(dim * 32, 0);
+    for (int k = 0; k < 32; ++k)
+        directions[k] = 1u << (31 - k);
+
+    for (int d = 1; d < dim; ++d)
+    {
+        const SobolPolynomial& poly = polynomials[d - 1];
+        unsigned* v = &directions[d * 32];
+        for (int k = 0; k < poly.degree; ++k)
+            v[k] = poly.m[k] << (31 - k);
+
+        for (int k = poly.degree; k < 32; ++k)
+        {
+            v[k] = v[k - poly.degree] ^ (v[k - poly.degree] >> poly.degree);
+            for (int j = 1; j < poly.degree; ++j)
+                if ((poly.a >> (poly.degree - 1 - j)) & 1)
+                    v[k] ^= v[k - j];
+        }
+    }
+}
+
+
+///  CalcIntegral_montecarlo()   func(const double* x) 
+///   [lower, upper]  lower.size()  samples .
+///      MC_BLOCK_POINTS,   ,   
+///     ,    seed   ; 
+///      ,    seed
+///       .
+///  pseudo_random  -    ;
+///  halton  sobol    QMC_REPLICATES  
+/// ,       .
+///     NAN
+template <typename Func>
+IntegralResult CalcIntegral_montecarlo(const std::vector<double>& lower, const std::vector<double>& upper,
+    const Func& func, long samples, esampling sampling, unsigned long long seed)
+{
+    const int dim = static_cast<int>(lower.size());
+    const int replicates = sampling == esampling::pseudo_random ? 1 : QMC_REPLICATES;
+    const long per_replicate = samples / replicates;
+
+    if (dim < 1 || upper.size() != lower.size() || per_replicate < 2
+        || (sampling != esampling::pseudo_random && dim > QMC_MAX_DIMENSIONS))
+        return { NAN, NAN, 0 };
+
+    double volume = 1.0;
+    for (int d = 0; d < dim; ++d)
+        volume *= upper[d] - lower[d];
+
+    std::vector<unsigned> directions;
+    if (sampling == esampling::sobol)
+        SobolDirections(dim, directions);
+
+    //      
+    std::vector<double> shifts(replicates * dim, 0.0);
+    if (sampling != esampling::pseudo_random)
+    {
+        for (int i = 0; i < replicates * dim; ++i)
+            shifts[i] = ToUnitInterval(SplitMix64(seed ^ SplitMix64(i + 1)));
+    }
+
+    const long blocks_per_replicate = (per_replicate + MC_BLOCK_POINTS - 1) / MC_BLOCK_POINTS;
+    const long block_count = blocks_per_replicate * replicates;
+
+    //          
+    std::vector<double> block_mean(block_count);
+    std::vector<double> block_m2(block_count);
+
+    cilk_for(long block = 0; block < block_count; ++block)
+    {
+        const long replicate = block / blocks_per_replicate;
+        const long first = (block % blocks_per_replicate) * MC_BLOCK_POINTS;
+        const long last = std::min(first + MC_BLOCK_POINTS, per_replicate);
+        const double* shift = &shifts[replicate * dim];
+
+        std::mt19937_64 generator(SplitMix64(seed + SplitMix64(block)));
+        std::vector<double> x(dim);
+
+        //     first    
+        std::vector<unsigned> sobol_state(dim, 0);
+        if (sampling == esampling::sobol)
+        {
+            const unsigned long gray = first ^ (first >> 1);
+            for (int d = 0; d < dim; ++d)
+                for (int k = 0; k < 32; ++k)
+                    if ((gray >> k) & 1)
+                        sobol_state[d] ^= directions[d * 32 + k];
+        }
+
+        double mean = 0.0;
+        double m2 = 0.0;
+        for (long i = first; i < last; ++i)
+        {
+            for (int d = 0; d < dim; ++d)
+            {
+                double u;
+                if (sampling == esampling::pseudo_random)
+                {
+                    u = ToUnitInterval(generator());
+                }
+                else
+                {
+                    u = sampling == esampling::halton ? RadicalInverse(i, Primes()[d])
+                                                      : sobol_state[d] * (1.0 / 4294967296.0);
+                    u += shift[d];
+                    if (u >= 1.0)
+                        u -= 1.0;
+                }
+                x[d] = lower[d] + (upper[d] - lower[d]) * u;
+            }
+
+            //  
+            const double value = func(x.data());
+            const double delta = value - mean;
+            mean += delta / (i - first + 1);
+            m2 += delta * (value - mean);
+
+            if (sampling == esampling::sobol)
+            {
+                //        
+                //      i
+                int k = 0;
+                for (long bits = i; bits & 1; bits >>= 1)
+                    ++k;
+                for (int d = 0; d < dim; ++d)
+                    sobol_state[d] ^= directions[d * 32 + k];
+            }
+        }
+
+        block_mean[block] = mean;
+        block_m2[block] = m2;
+    }
+
+    //     ( )   ,
+    //    
+    double value = 0.0;
+    double replicate_m2 = 0.0;
+    double error = 0.0;
+    for (long replicate = 0; replicate < replicates; ++replicate)
+    {
+        double mean = 0.0;
+        double m2 = 0.0;
+        long count = 0;
+        for (long block = replicate * blocks_per_replicate; block < (replicate + 1) * blocks_per_replicate; ++block)
+        {
+            const long first = (block % blocks_per_replicate) * MC_BLOCK_POINTS;
+            const long size = std::min(first + MC_BLOCK_POINTS, per_replicate) - first;
+            const double delta = block_mean[block] - mean;
+            count += size;
+            mean += delta * size / count;
+            m2 += block_m2[block] + delta * delta * (static_cast<double>(count - size) * size / count);
+        }
+
+        if (replicates == 1)
+        {
+            value = mean;
+            error = std::sqrt(m2 / (count - 1) / count);
+        }
+        else
+        {
+            const double delta = mean - value;
+            value += delta / (replicate + 1);
+            replicate_m2 += delta * (mean - value);
+        }
+    }
+
+    if (replicates > 1)
+        error = std::sqrt(replicate_m2 / (replicates - 1) / replicates);
+
+    return { volume * value, volume * error, per_replicate * replicates };
+}
+
+
+///  RunMicrobenchmarks()     
+/// BenchmarkHarness;   -    (  - 
+///  ITERATIONS ,   - -  )
+void RunMicrobenchmarks()
+{
+    const double beg = -1.;
+    const double end = 1.;
+    const InverseSqrtFunction fnFunction = { 5., 8., 4. };
+    const Integrand fnErased = fnFunction;
+
+    const int dimensions = 6;
+    auto fnMulti = [](const double* x) -> double
+                   {
+                       double res = 1.;
+                       for (int d = 0; d < dimensions; ++d)
+                           res *= x[d] * (1. - x[d]);
+                       return res;
+                   };
+    const std::vector<double> lower(dimensions, 0.);
+    const std::vector<double> upper(dimensions, 1.);
+
+    std::vector<IntegrationJob<InverseSqrtFunction>> jobs;
+
+    BenchmarkHarness harness;
+    harness.Add("integral_serial", [&](const long long size)
+    {
+        KeepResult(CalcIntegral(beg, end, fnFunction, static_cast<int>(size)));
+    });
+    harness.Add("integral_std_function", [&](const long long size)
+    {
+        KeepResult(CalcIntegral(beg, end, fnErased, static_cast<int>(size)));
+    });
+    harness.Add("integral_paralel", [&](const long long size)
+    {
+        KeepResult(CalcIntegral_paralel(beg, end, fnFunction, static_cast<int>(size)));
+    });
+    //       ; 
+    //   ,      
+    harness.Add("integral_auto",
+        [](const long long) { GetIntegrationTuning(); },
+        [&](const long long size) { KeepResult(CalcIntegral_auto(beg, end, fnFunction, static_cast<int>(size))); });
+    harness.Add("integral_batch",
+        [&](const long long size)
+        {
+            jobs.clear();
+            for (int i = 0; i < ITERATIONS; ++i)
+            {
+                const double shift = 0.5 * i / ITERATIONS;
+                jobs.push_back({ beg + shift, end - shift, fnFunction, std::max(1, static_cast<int>(size / ITERATIONS)) });
+            }
+        },
+        [&](const long long) { KeepResult(CalcIntegralBatch(jobs).back()); });
+    harness.Add("montecarlo", [&](const long long size)
+    {
+        KeepResult(CalcIntegral_montecarlo(lower, upper, fnMulti, static_cast<long>(size), esampling::pseudo_random, 1).value);
+    });
+    harness.Add("montecarlo_sobol", [&](const long long size)
+    {
+        KeepResult(CalcIntegral_montecarlo(lower, upper, fnMulti, static_cast<long>(size), esampling::sobol, 1).value);
+    });
+
+    BenchmarkOptions options;
+    options.sizes = { 1000, 10000, 100000, 1000000 };
+    options.workers = { 1, 2, 4, 8 };
+    harness.Run(options);
+}
+
+
 int main()
 {
+    if (MICROBENCHMARK_MODE)
+    {
+        RunMicrobenchmarks();
+        return 0;
+    }
+
+
     //     = 4
     __cilkrts_set_param("nworkers", "4");
 
     const double beg = -1.;
     const double end = 1.;
 
-    auto fnFunction = [](double x) -> double
-                      {
-                          return 5. / std::sqrt(8 - 4*x*x);
-                      };
+    // 5 / sqrt(8 - 4*x*x)   SIMD- 
+    const InverseSqrtFunction fnFunction = { 5., 8., 4. };
     std::vector<int> vals = { 10, 100, 1000, 10000 };
 
+    const IntegrationTuning tuning = GetIntegrationTuning();
+    printf("Tuning for %d workers: parallel from %d breaks, grain - %d points\n",
+        tuning.workers, tuning.parallel_cutoff, tuning.grain_points);
+
+    //       -     
+    const Integrand fnErased = fnFunction;
+
     for (auto && val : vals)
     {
+        SerialShell(beg, end, fnErased, val);
+        const double erased_time = duration_s.count();
+
         double res = SerialShell(beg, end, fnFunction, val);
-        double resP = ParalelShell(beg, end, fnFunction, val);
+        ParalelShell(beg, end, fnFunction, val);
+        AutoShell(beg, end, fnFunction, val);
 
-        printf("Number of breaks: %d.\t Result: %f. Serial time -\t %f, paralel time - \t %f\n", val, res, duration_s.count(), duration_p.count());
+        printf("Number of breaks: %d.\t Result: %f. Serial time -\t %f, paralel time - \t %f, auto time - \t %f, std::function serial time - \t %f\n",
+            val, res, duration_s.count(), duration_p.count(), duration_a.count(), erased_time);
     }
 
+    //   ITERATIONS     :
+    //   CalcIntegral_paralel()    CalcIntegralBatch()
+    for (auto && val : vals)
+    {
+        std::vector<IntegrationJob<InverseSqrtFunction>> jobs;
+        for (int i = 0; i < ITERATIONS; ++i)
+        {
+            const double shift = 0.5 * i / ITERATIONS;
+            jobs.push_back({ beg + shift, end - shift, fnFunction, val });
+        }
+
+        std::vector<double> loop_results(jobs.size());
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < jobs.size(); ++i)
+            loop_results[i] = CalcIntegral_paralel(jobs[i].beg, jobs[i].end, jobs[i].func, jobs[i].N);
+        std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+        std::vector<double> batch_results = CalcIntegralBatch(jobs);
+        std::chrono::high_resolution_clock::time_point t3 = std::chrono::high_resolution_clock::now();
+
+        printf("Batch of %d integrals, number of breaks: %d.\t Last result: %f. Loop of paralel calls -\t %f, batch - \t %f\n",
+            ITERATIONS, val, batch_results.back(), std::chrono::duration<double>(t2 - t1).count(),
+            std::chrono::duration<double>(t3 - t2).count());
+    }
+
+    //   : 5/2 * (asin(1/sqrt(2)) - asin(-1/sqrt(2))) = 5*pi/4
+    const double exact = 5. * std::acos(-1.) / 4.;
+    std::vector<double> tolerances = { 1e-4, 1e-8, 1e-12 };
+
+    for (auto && tolerance : tolerances)
+    {
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        IntegralResult res = CalcIntegral_adaptive(beg, end, fnFunction, tolerance);
+        std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+        printf("Adaptive tolerance: %g.\t Result: %.15f. Error estimate - %g, actual error - %g, evaluations - %ld, time - %f\n",
+            tolerance, res.value, res.error, std::fabs(res.value - exact), res.evaluations,
+            std::chrono::duration<double>(t2 - t1).count());
+    }
+
+    //  :  pi/2 * sin(pi*x_d)   ,   1
+    const int dimensions = 6;
+    auto fnMulti = [](const double* x) -> double
+                   {
+                       double res = 1.;
+                       for (int d = 0; d < dimensions; ++d)
+                           res *= 0.5 * std::acos(-1.) * std::sin(std::acos(-1.) * x[d]);
+                       return res;
+                   };
+    const std::vector<double> lower(dimensions, 0.);
+    const std::vector<double> upper(dimensions, 1.);
+    const esampling samplings[] = { esampling::pseudo_random, esampling::halton, esampling::sobol };
+    const char* sampling_names[] = { "Monte Carlo", "Halton", "Sobol" };
+    const unsigned long long seed = 2018;
+
+    for (long samples : { 1L << 16, 1L << 20 })
+    {
+        for (int s = 0; s < 3; ++s)
+        {
+            std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            IntegralResult res = CalcIntegral_montecarlo(lower, upper, fnMulti, samples, samplings[s], seed);
+            std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+            printf("%s, %d dimensions, %ld samples.\t Result: %.10f. Error estimate - %g, actual error - %g, time - %f\n",
+                sampling_names[s], dimensions, res.evaluations, res.value, res.error, std::fabs(res.value - 1.),
+                std::chrono::duration<double>(t2 - t1).count());
+        }
+    }
+
+    //            
+    const IntegralResult multi_result = CalcIntegral_montecarlo(lower, upper, fnMulti, 1L << 20, esampling::pseudo_random, seed);
+    __cilkrts_end_cilk();
+    __cilkrts_set_param("nworkers", "1");
+    const IntegralResult single_result = CalcIntegral_montecarlo(lower, upper, fnMulti, 1L << 20, esampling::pseudo_random, seed);
+    __cilkrts_end_cilk();
+    __cilkrts_set_param("nworkers", "4");
+
+    printf("Monte Carlo with 4 and 1 workers: %.17g and %.17g - %s\n", multi_result.value, single_result.value,
+        multi_result.value == single_result.value ? "identical" : "DIFFERENT");
+
     return 0;
 }
\ No newline at end of file
@@ -7,61 +7,125 @@
 #include <cilk/cilk_api.h>
 #include <cilk/reducer_max.h>
 #include <cilk/reducer_min.h>
-#include <cilk/reducer_vector.h>
 
 #include <chrono>
 #include <vector>
 
+#include "../../common/benchmark.h"
+#include "../../common/counter_rng.h"
+#include "../../common/parallel_fill.h"
+
 using namespace std::chrono;
 
+//  :      
+// BenchmarkHarness (, , ),     CSV
+constexpr bool MICROBENCHMARK_MODE = false;
+
 ///  CompareForAndCilk_For
 /// size -   
-void CompareForAndCilk_For(size_t size)
+/// seed -      
+void CompareForAndCilk_For(size_t size, const unsigned long long seed)
 {
 	constexpr int max_value = 20000;
-	printf("Size %d \t", size);
+	//    rand()     ,
+	//       
+	const PhiloxRng rng(seed);
+	printf("Size %zu \t", size);
 
 	//   
-	std::vector<int> vec{};
-	vec.reserve(size);
+	std::vector<int> vec(size);
 
+	//      ,      
 	high_resolution_clock::time_point t1 = high_resolution_clock::now();
-	for (long i = 0; i < size; ++i)
-	{
-		vec.push_back(rand() % max_value + 1);
-	}
+	FillUniformInt(vec.data(), 0, static_cast<long long>(size), rng, 1, max_value);
 	high_resolution_clock::time_point t2 = high_resolution_clock::now();
 
 	duration<double> duration1 = (t2 - t1);
 	printf("For - %f  :", duration1.count());
 
-	//   
-	cilk::reducer<cilk::op_vector<int>>red_vec;
+	//   :       
+	std::vector<int> par_vec(size);
 
 	high_resolution_clock::time_point t3 = high_resolution_clock::now();
-	cilk_for(long i = 0; i < size; ++i)
-	{
-		red_vec->push_back(rand() % max_value + 1);
-	}
+	ParallelFillUniformInt(par_vec.data(), static_cast<long long>(size), rng, 1, max_value);
 	high_resolution_clock::time_point t4 = high_resolution_clock::now();
 
 	duration<double> duration2 = (t4 - t3);
-	printf("  %f - Cilk_For\n", duration2.count());
+	printf("  %f - Cilk_For", duration2.count());
+
+	//     max_value / 2   
+	std::vector<int> filtered{};
+
+	high_resolution_clock::time_point t5 = high_resolution_clock::now();
+	ParallelAppendIf(filtered, static_cast<long long>(size),
+		[&par_vec](const long long i) { return par_vec[i]; },
+		[](const int value) { return value > max_value / 2; });
+	high_resolution_clock::time_point t6 = high_resolution_clock::now();
+
+	duration<double> duration3 = (t6 - t5);
+	printf("  :  %f - Cilk_For filter (%zu kept)\n", duration3.count(), filtered.size());
+}
+
+
+///  RunMicrobenchmarks()   CompareForAndCilk_For()  
+/// BenchmarkHarness         
+/// sizes -   
+/// seed -      
+void RunMicrobenchmarks(const std::vector<size_t>& sizes, const unsigned long long seed)
+{
+	constexpr int max_value = 20000;
+	const PhiloxRng rng(seed);
+	std::vector<int> vec;
+	std::vector<int> source;
+
+	BenchmarkHarness harness;
+	harness.Add("for_fill", [&](const long long size) { vec.resize(size); },
+		[&](const long long size) { FillUniformInt(vec.data(), 0, size, rng, 1, max_value); });
+	harness.Add("cilk_for_fill", [&](const long long size) { vec.resize(size); },
+		[&](const long long size) { ParallelFillUniformInt(vec.data(), size, rng, 1, max_value); });
+	//     :   
+	harness.Add("cilk_for_filter",
+		[&](const long long size)
+		{
+			vec.clear();
+			if (static_cast<long long>(source.size()) != size)
+			{
+				source.resize(size);
+				ParallelFillUniformInt(source.data(), size, rng, 1, max_value);
+			}
+		},
+		[&](const long long size)
+		{
+			ParallelAppendIf(vec, size, [&source](const long long i) { return source[i]; },
+				[](const int value) { return value > max_value / 2; });
+		});
+
+	BenchmarkOptions options;
+	options.sizes.assign(sizes.begin(), sizes.end());
+	options.workers = { 1, 2, 4, 8 };
+	harness.Run(options);
 }
 
 
 int main()
 {
+	const unsigned long long seed = static_cast<unsigned long long>(time(0));
+	std::vector<size_t> sizes{ 1000000, 100000, 10000, 1000, 500, 100, 50, 10 };
+
+	if (MICROBENCHMARK_MODE)
+	{
+		RunMicrobenchmarks(sizes, seed);
+		return 0;
+	}
+
 	printf("Compare For and Cilk_For test.\n\n");
-	srand((unsigned)time(0));
 
 	//     = 4
 	__cilkrts_set_param("nworkers", "4");
 
-	std::vector<size_t> sizes{ 1000000, 100000, 10000, 1000, 500, 100, 50, 10 };
 	for (auto size : sizes)
 	{
-		CompareForAndCilk_For(size);
+		CompareForAndCilk_For(size, seed);
 	}
 
 	return 0;
@@ -7,111 +7,683 @@
 #include <cilk/cilk_api.h>
 #include <cilk/reducer_max.h>
 #include <cilk/reducer_min.h>
-#include <cilk/reducer_vector.h>
 
+#include <algorithm>
 #include <chrono>
+#include <utility>
 #include <vector>
 
+#include "../../common/benchmark.h"
+#include "../../common/counter_rng.h"
+
 using namespace std::chrono;
 
-///  ReducerMaxTest()    ,
-///     ,   
+//  :      
+//  BenchmarkHarness,     CSV
+constexpr bool MICROBENCHMARK_MODE = false;
+//    SORT_SPAWN_CUTOFF   (std::sort - 
+// ),   -  PIVOT_SAMPLES ,    
+constexpr long SORT_SPAWN_CUTOFF = 4096;
+constexpr int PIVOT_SAMPLES = 9;
+//   PARALLEL_PARTITION_CUTOFF  ,
+//   PARTITION_BLOCK 
+constexpr long PARALLEL_PARTITION_CUTOFF = 1L << 17;
+constexpr long PARTITION_BLOCK = 1L << 14;
+//  :   RADIX_BITS ,    
+//  RADIX_BLOCK ;   ,   
+//   RADIX_SORT_MAX_RANGE
+constexpr int RADIX_BITS = 8;
+constexpr int RADIX_BUCKETS = 1 << RADIX_BITS;
+constexpr long RADIX_BLOCK = 1L << 16;
+constexpr unsigned RADIX_SORT_MAX_RANGE = 1u << 16;
+//     :   MINMAX_CHUNK
+// ,   - MINMAX_LANES  SIMD-
+constexpr long MINMAX_CHUNK = 1L << 16;
+constexpr int MINMAX_LANES = 8;
+
+/// ,      ParallelSort()
+enum class esort_algorithm
+{
+	automatic = 0,
+	quicksort,
+	radix
+};
+
+///  ReducerMax()       
+///    op_max_index;   (, )
 /// mass_pointer -     
 /// size -    
-void ReducerMaxTest(int *mass_pointer, const long size)
+std::pair<int, long> ReducerMax(const int *mass_pointer, const long size)
 {
 	cilk::reducer<cilk::op_max_index<long, int>> maximum;
 	cilk_for(long i = 0; i < size; ++i)
 	{
 		maximum->calc_max(i, mass_pointer[i]);
 	}
-	printf("Maximal element = %d has index = %d\n",
-		maximum->get_reference(), maximum->get_index_reference());
+	return std::make_pair(maximum->get_reference(), maximum->get_index_reference());
 }
 
 
-///  ReducerMinTest()    ,
-///     ,   
+///  ReducerMin()       
+///    op_min_index;   (, )
 /// mass_pointer -     
 /// size -    
-void ReducerMinTest(int *mass_pointer, const long size)
+std::pair<int, long> ReducerMin(const int *mass_pointer, const long size)
 {
 	cilk::reducer<cilk::op_min_index<long, int>> minimum;
 	cilk_for(long i = 0; i < size; ++i)
 	{
 		minimum->calc_min(i, mass_pointer[i]);
 	}
-	printf("Minimal element = %d has index = %d\n",
-		minimum->get_reference(), minimum->get_index_reference());
+	return std::make_pair(minimum->get_reference(), minimum->get_index_reference());
+}
+
+
+///  ReducerMaxTest()    ,
+///     ,   
+/// mass_pointer -     
+/// size -    
+void ReducerMaxTest(int *mass_pointer, const long size)
+{
+	const std::pair<int, long> maximum = ReducerMax(mass_pointer, size);
+	printf("Maximal element = %d has index = %ld\n", maximum.first, maximum.second);
+}
+
+
+///  ReducerMinTest()    ,
+///     ,   
+/// mass_pointer -     
+/// size -    
+void ReducerMinTest(int *mass_pointer, const long size)
+{
+	const std::pair<int, long> minimum = ReducerMin(mass_pointer, size);
+	printf("Minimal element = %d has index = %ld\n", minimum.first, minimum.second);
+}
+
+
+///  MinMaxResult -     
+///     
+struct MinMaxResult
+{
+	int min_value;
+	long min_index;
+	int max_value;
+	long max_index;
+};
+
+
+///  CombineMinMax()      ;
+///      
+MinMaxResult CombineMinMax(const MinMaxResult& a, const MinMaxResult& b)
+{
+	MinMaxResult res = a;
+	if (b.min_value < res.min_value || (b.min_value == res.min_value && b.min_index < res.min_index))
+	{
+		res.min_value = b.min_value;
+		res.min_index = b.min_index;
+	}
+	if (b.max_value > res.max_value || (b.max_value == res.max_value && b.max_index < res.max_index))
+	{
+		res.max_value = b.max_value;
+		res.max_index = b.max_index;
+	}
+	return res;
+}
+
+
+///  MinMaxChunk()      [first, last)  data
+///   :   MINMAX_LANES    , 
+///   ,       
+MinMaxResult MinMaxChunk(const int *data, const long first, const long last)
+{
+	int lane_min[MINMAX_LANES];
+	int lane_max[MINMAX_LANES];
+	long lane_min_index[MINMAX_LANES];
+	long lane_max_index[MINMAX_LANES];
+	for (int lane = 0; lane < MINMAX_LANES; ++lane)
+	{
+		lane_min[lane] = lane_max[lane] = data[first];
+		lane_min_index[lane] = lane_max_index[lane] = first;
+	}
+
+	long i = first;
+	for (; i + MINMAX_LANES <= last; i += MINMAX_LANES)
+	{
+#pragma omp simd
+		for (int lane = 0; lane < MINMAX_LANES; ++lane)
+		{
+			const int value = data[i + lane];
+			if (value < lane_min[lane])
+			{
+				lane_min[lane] = value;
+				lane_min_index[lane] = i + lane;
+			}
+			if (value > lane_max[lane])
+			{
+				lane_max[lane] = value;
+				lane_max_index[lane] = i + lane;
+			}
+		}
+	}
+
+	MinMaxResult res = { lane_min[0], lane_min_index[0], lane_max[0], lane_max_index[0] };
+	for (int lane = 1; lane < MINMAX_LANES; ++lane)
+	{
+		res = CombineMinMax(res, { lane_min[lane], lane_min_index[lane], lane_max[lane], lane_max_index[lane] });
+	}
+	for (; i < last; ++i)
+	{
+		res = CombineMinMax(res, { data[i], i, data[i], i });
+	}
+	return res;
+}
+
+
+///  FindMinMax()      
+///             MINMAX_CHUNK
+/// .     (sorted)     
+///  :  -  ,      .
+///         -1
+/// data -    
+/// size -    
+/// sorted -    
+MinMaxResult FindMinMax(const int *data, const long size, const bool sorted = false)
+{
+	if (size <= 0)
+	{
+		return { 0, -1, 0, -1 };
+	}
+
+	if (sorted)
+	{
+		const long max_index = static_cast<long>(std::lower_bound(data, data + size, data[size - 1]) - data);
+		return { data[0], 0, data[size - 1], max_index };
+	}
+
+	const long chunks = (size + MINMAX_CHUNK - 1) / MINMAX_CHUNK;
+	std::vector<MinMaxResult> partial(chunks);
+
+	cilk_for(long c = 0; c < chunks; ++c)
+	{
+		partial[c] = MinMaxChunk(data, c * MINMAX_CHUNK, std::min((c + 1) * MINMAX_CHUNK, size));
+	}
+
+	MinMaxResult res = partial[0];
+	for (long c = 1; c < chunks; ++c)
+	{
+		res = CombineMinMax(res, partial[c]);
+	}
+	return res;
+}
+
+
+///  MinMaxTest()      
+///  FindMinMax()   ,     
+/// mass_pointer -     
+/// size -    
+/// sorted -    
+void MinMaxTest(int *mass_pointer, const long size, const bool sorted)
+{
+	high_resolution_clock::time_point t1 = high_resolution_clock::now();
+	const MinMaxResult res = FindMinMax(mass_pointer, size, sorted);
+	high_resolution_clock::time_point t2 = high_resolution_clock::now();
+
+	duration<double> duration = (t2 - t1);
+	printf("Fused scan: minimal element = %d has index = %ld, maximal element = %d has index = %ld, duration is %f seconds\n",
+		res.min_value, res.min_index, res.max_value, res.max_index, duration.count());
+}
+
+
+///  SamplePivot()      PIVOT_SAMPLES 
+///  [begin, end),    ;    PIVOT_SAMPLES
+int SamplePivot(const int *begin, const int *end)
+{
+	int samples[PIVOT_SAMPLES];
+	const long step = static_cast<long>(end - begin) / PIVOT_SAMPLES;
+	for (int i = 0; i < PIVOT_SAMPLES; ++i)
+	{
+		samples[i] = begin[i * step + step / 2];
+	}
+	std::nth_element(samples, samples + PIVOT_SAMPLES / 2, samples + PIVOT_SAMPLES);
+	return samples[PIVOT_SAMPLES / 2];
+}
+
+
+///  ThreeWayPartition()    [begin, end) , 
+///     pivot,   ,  ;
+///     
+std::pair<int*, int*> ThreeWayPartition(int *begin, int *end, const int pivot)
+{
+	int *less_end = begin;
+	int *greater_begin = end;
+	int *current = begin;
+	while (current < greater_begin)
+	{
+		if (*current < pivot)
+		{
+			std::swap(*less_end++, *current++);
+		}
+		else if (*current > pivot)
+		{
+			std::swap(*current, *--greater_begin);
+		}
+		else
+		{
+			++current;
+		}
+	}
+	return std::make_pair(less_end, greater_begin);
+}
+
+
+///  ParallelThreeWayPartition() -   ThreeWayPartition():
+///    PARTITION_BLOCK     , 
+///   pivot,       
+///   buffer   ,   ,     
+std::pair<int*, int*> ParallelThreeWayPartition(int *begin, int *end, const int pivot, int *buffer)
+{
+	const long size = static_cast<long>(end - begin);
+	const long blocks = (size + PARTITION_BLOCK - 1) / PARTITION_BLOCK;
+	std::vector<long> less(blocks + 1, 0);
+	std::vector<long> equal(blocks + 1, 0);
+
+	cilk_for(long b = 0; b < blocks; ++b)
+	{
+		const int *block_end = begin + std::min((b + 1) * PARTITION_BLOCK, size);
+		long less_count = 0;
+		long equal_count = 0;
+		for (const int *it = begin + b * PARTITION_BLOCK; it < block_end; ++it)
+		{
+			less_count += *it < pivot;
+			equal_count += *it == pivot;
+		}
+		less[b] = less_count;
+		equal[b] = equal_count;
+	}
+
+	//    less[b]  equal[b] -       b
+	long less_total = 0;
+	long equal_total = 0;
+	for (long b = 0; b <= blocks; ++b)
+	{
+		const long less_count = less[b];
+		const long equal_count = equal[b];
+		less[b] = less_total;
+		equal[b] = equal_total;
+		less_total += less_count;
+		equal_total += equal_count;
+	}
+
+	cilk_for(long b = 0; b < blocks; ++b)
+	{
+		const long first = b * PARTITION_BLOCK;
+		const long last = std::min(first + PARTITION_BLOCK, size);
+		int *less_out = buffer + less[b];
+		int *equal_out = buffer + less_total + equal[b];
+		//   pivot    b: first - less[b] - equal[b]
+		int *greater_out = buffer + less_total + equal_total + (first - less[b] - equal[b]);
+		for (long i = first; i < last; ++i)
+		{
+			const int value = begin[i];
+			if (value < pivot)
+			{
+				*less_out++ = value;
+			}
+			else if (value == pivot)
+			{
+				*equal_out++ = value;
+			}
+			else
+			{
+				*greater_out++ = value;
+			}
+		}
+	}
+
+	cilk_for(long first = 0; first < size; first += PARTITION_BLOCK)
+	{
+		std::copy(buffer + first, buffer + std::min(first + PARTITION_BLOCK, size), begin + first);
+	}
+
+	return std::make_pair(begin + less_total, begin + less_total + equal_total);
+}
+
+
+///  ParallelSortRange() -      [begin, end);
+/// depth_limit -     :    
+///  std::sort,    O(n log n)    
+/// buffer -        ( nullptr,
+///     PARALLEL_PARTITION_CUTOFF)
+void ParallelSortRange(int *begin, int *end, int depth_limit, int *buffer)
+{
+	if (end - begin <= SORT_SPAWN_CUTOFF || depth_limit == 0)
+	{
+		std::sort(begin, end);
+		return;
+	}
+
+	//        ,  
+	//        ,    ;
+	//   ,   ,  ,  
+	//   
+	const int pivot = SamplePivot(begin, end);
+	const std::pair<int*, int*> equal = end - begin > PARALLEL_PARTITION_CUTOFF
+		? ParallelThreeWayPartition(begin, end, pivot, buffer)
+		: ThreeWayPartition(begin, end, pivot);
+	cilk_spawn ParallelSortRange(begin, equal.first, depth_limit - 1, buffer);
+	ParallelSortRange(equal.second, end, depth_limit - 1, buffer + (equal.second - begin));
+	cilk_sync;
+}
+
+
+///  ParallelQuickSort()     
+/// begin -      
+/// end -   ,      
+void ParallelQuickSort(int *begin, int *end)
+{
+	int depth_limit = 0;
+	for (long size = static_cast<long>(end - begin); size > 1; size /= 2)
+	{
+		depth_limit += 2;
+	}
+
+	std::vector<int> buffer(end - begin > PARALLEL_PARTITION_CUTOFF ? end - begin : 0);
+	ParallelSortRange(begin, end, depth_limit, buffer.data());
+}
+
+
+///  ParallelRadixSort()     (LSD)  
+/// value - min:  ,  RADIX_BITS-    .
+///         , 
+///         ,   
+///     ;    
+/// begin -      
+/// end -   ,      
+/// min_value, max_value -     
+void ParallelRadixSort(int *begin, int *end, const int min_value, const int max_value)
+{
+	const long size = static_cast<long>(end - begin);
+	if (size < 2)
+	{
+		return;
+	}
+
+	const unsigned min_key = static_cast<unsigned>(min_value);
+	const unsigned range = static_cast<unsigned>(max_value) - min_key;
+
+	const long blocks = (size + RADIX_BLOCK - 1) / RADIX_BLOCK;
+	// counts[b * RADIX_BUCKETS + d] -     d   b,
+	//    -       
+	std::vector<long> counts(blocks * RADIX_BUCKETS);
+	std::vector<long> digit_offsets(RADIX_BUCKETS);
+	std::vector<int> buffer(size);
+	int *src = begin;
+	int *dst = buffer.data();
+
+	for (int shift = 0; shift < 32 && (range >> shift) != 0; shift += RADIX_BITS)
+	{
+		cilk_for(long b = 0; b < blocks; ++b)
+		{
+			long *histogram = &counts[b * RADIX_BUCKETS];
+			std::fill(histogram, histogram + RADIX_BUCKETS, 0L);
+			const long last = std::min((b + 1) * RADIX_BLOCK, size);
+			for (long i = b * RADIX_BLOCK; i < last; ++i)
+			{
+				++histogram[((static_cast<unsigned>(src[i]) - min_key) >> shift) & (RADIX_BUCKETS - 1)];
+			}
+		}
+
+		//     (, ):  
+		//    ,      
+		cilk_for(int d = 0; d < RADIX_BUCKETS; ++d)
+		{
+			long total = 0;
+			for (long b = 0; b < blocks; ++b)
+			{
+				total += counts[b * RADIX_BUCKETS + d];
+			}
+			digit_offsets[d] = total;
+		}
+
+		long offset = 0;
+		for (int d = 0; d < RADIX_BUCKETS; ++d)
+		{
+			const long total = digit_offsets[d];
+			digit_offsets[d] = offset;
+			offset += total;
+		}
+
+		cilk_for(int d = 0; d < RADIX_BUCKETS; ++d)
+		{
+			long position = digit_offsets[d];
+			for (long b = 0; b < blocks; ++b)
+			{
+				const long count = counts[b * RADIX_BUCKETS + d];
+				counts[b * RADIX_BUCKETS + d] = position;
+				position += count;
+			}
+		}
+
+		cilk_for(long b = 0; b < blocks; ++b)
+		{
+			long *positions = &counts[b * RADIX_BUCKETS];
+			const long last = std::min((b + 1) * RADIX_BLOCK, size);
+			for (long i = b * RADIX_BLOCK; i < last; ++i)
+			{
+				dst[positions[((static_cast<unsigned>(src[i]) - min_key) >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+			}
+		}
+
+		std::swap(src, dst);
+	}
+
+	if (src != begin)
+	{
+		cilk_for(long first = 0; first < size; first += RADIX_BLOCK)
+		{
+			std::copy(src + first, src + std::min(first + RADIX_BLOCK, size), begin + first);
+		}
+	}
 }
 
 
-///  ParallelSort()     
+///  ParallelRadixSort()    ,
+///         FindMinMax()
 /// begin -      
-/// end -      
-void ParallelSort(int *begin, int *end)
+/// end -   ,      
+void ParallelRadixSort(int *begin, int *end)
 {
-	if (begin != end)
+	const MinMaxResult min_max = FindMinMax(begin, static_cast<long>(end - begin));
+	ParallelRadixSort(begin, end, min_max.min_value, min_max.max_value);
+}
+
+
+///  ParallelSort()     ;  algorithm == automatic
+///      (  RADIX_SORT_MAX_RANGE) 
+///  ,  - 
+/// begin -      
+/// end -   ,      
+/// algorithm -  
+void ParallelSort(int *begin, int *end, esort_algorithm algorithm = esort_algorithm::automatic)
+{
+	// ,    ,   ,
+	//      
+	bool range_known = false;
+	MinMaxResult min_max = {};
+
+	if (algorithm == esort_algorithm::automatic)
+	{
+		algorithm = esort_algorithm::quicksort;
+		if (end - begin > SORT_SPAWN_CUTOFF)
+		{
+			min_max = FindMinMax(begin, static_cast<long>(end - begin));
+			range_known = true;
+			if (static_cast<unsigned>(min_max.max_value) - static_cast<unsigned>(min_max.min_value) <= RADIX_SORT_MAX_RANGE)
+			{
+				algorithm = esort_algorithm::radix;
+			}
+		}
+	}
+
+	switch (algorithm)
+	{
+	case esort_algorithm::quicksort:
+	{
+		ParallelQuickSort(begin, end);
+		break;
+	}
+	case esort_algorithm::radix:
 	{
-		--end;
-		int *middle = std::partition(begin, end, std::bind2nd(std::less<int>(), *end));
-		std::swap(*end, *middle);
-		cilk_spawn ParallelSort(begin, middle);
-		ParallelSort(++middle, ++end);
-		cilk_sync;
+		if (range_known)
+		{
+			ParallelRadixSort(begin, end, min_max.min_value, min_max.max_value);
+		}
+		else
+		{
+			ParallelRadixSort(begin, end);
+		}
+		break;
+	}
+	default:
+	{
+		throw("Incorrect value for parameter 'algorithm' in function ParallelSort() call!");
+	}
+	}
+}
+
+
+///  SortBenchmark()    <i>data</i>   
+/// ,        
+/// name -   
+/// data -  
+void SortBenchmark(const char *name, const std::vector<int>& data)
+{
+	const esort_algorithm algorithms[] = { esort_algorithm::quicksort, esort_algorithm::radix };
+	const char *algorithm_names[] = { "quicksort", "radix sort" };
+
+	printf("%s input:", name);
+	for (int a = 0; a < 2; ++a)
+	{
+		std::vector<int> copy(data);
+
+		high_resolution_clock::time_point t1 = high_resolution_clock::now();
+		ParallelSort(copy.data(), copy.data() + copy.size(), algorithms[a]);
+		high_resolution_clock::time_point t2 = high_resolution_clock::now();
+
+		duration<double> duration = (t2 - t1);
+		printf("%s %s - %f seconds%s", a == 0 ? "" : ",", algorithm_names[a], duration.count(),
+			std::is_sorted(copy.begin(), copy.end()) ? "" : " (NOT SORTED!)");
 	}
+	printf("\n");
 }
 
 
 ///  CompareForAndCilk_For 
-void CompareForAndCilk_For(size_t size)
+/// size -   
+/// seed -      
+void CompareForAndCilk_For(size_t size, const unsigned long long seed)
 {
 	constexpr int max_value = 20000;
+	//    rand()     ,
+	//       
+	const PhiloxRng rng(seed);
 
 	//   
-	std::vector<int> vec{};
-	vec.reserve(size);
+	std::vector<int> vec(size);
 
+	//      ,      
 	high_resolution_clock::time_point t1 = high_resolution_clock::now();
-	for (long i = 0; i < size; ++i)
-	{
-		vec.push_back(rand() % max_value + 1);
-	}
+	FillUniformInt(vec.data(), 0, static_cast<long long>(size), rng, 1, max_value);
 	high_resolution_clock::time_point t2 = high_resolution_clock::now();
 
 	duration<double> duration1 = (t2 - t1);
 	printf("Duration is: %f seconds\n", duration1.count());
 
-	//   
-	cilk::reducer<cilk::op_vector<int>>red_vec;
+	//   :       
+	std::vector<int> par_vec(size);
 
 	high_resolution_clock::time_point t3 = high_resolution_clock::now();
-	cilk_for(long i = 0; i < size; ++i)
-	{
-		red_vec->push_back(rand() % max_value + 1);
-	}
+	ParallelFillUniformInt(par_vec.data(), static_cast<long long>(size), rng, 1, max_value);
 	high_resolution_clock::time_point t4 = high_resolution_clock::now();
 
-	duration<double> duration2 = (t3 - t4);
+	duration<double> duration2 = (t4 - t3);
 	printf("Duration is: %f seconds\n", duration2.count());
 }
 
 
+///  RunMicrobenchmarks()      BenchmarkHarness
+///         
+/// seed -     
+void RunMicrobenchmarks(const unsigned long long seed)
+{
+	constexpr int max_value = 25000;
+	const PhiloxRng rng(seed);
+	std::vector<int> input;
+	std::vector<int> work;
+
+	//       ,   -   
+	auto prepare_input = [&](const long long size)
+	{
+		if (static_cast<long long>(input.size()) != size)
+		{
+			input.resize(size);
+			ParallelFillUniformInt(input.data(), size, rng, 1, max_value);
+		}
+	};
+	auto prepare_copy = [&](const long long size)
+	{
+		prepare_input(size);
+		work.assign(input.begin(), input.end());
+	};
+
+	BenchmarkHarness harness;
+	harness.Add("for_fill", [&](const long long size) { work.resize(size); },
+		[&](const long long size) { FillUniformInt(work.data(), 0, size, rng, 1, max_value); });
+	harness.Add("parallel_fill", [&](const long long size) { work.resize(size); },
+		[&](const long long size) { ParallelFillUniformInt(work.data(), size, rng, 1, max_value); });
+	harness.Add("reducer_max_min", prepare_input, [&](const long long size)
+	{
+		KeepResult(ReducerMax(input.data(), static_cast<long>(size)).second + ReducerMin(input.data(), static_cast<long>(size)).second);
+	});
+	harness.Add("fused_min_max", prepare_input, [&](const long long size)
+	{
+		KeepResult(FindMinMax(input.data(), static_cast<long>(size)).max_index);
+	});
+	harness.Add("std_sort", prepare_copy, [&](const long long) { std::sort(work.begin(), work.end()); });
+	harness.Add("quicksort", prepare_copy, [&](const long long)
+	{
+		ParallelSort(work.data(), work.data() + work.size(), esort_algorithm::quicksort);
+	});
+	harness.Add("radix_sort", prepare_copy, [&](const long long)
+	{
+		ParallelSort(work.data(), work.data() + work.size(), esort_algorithm::radix);
+	});
+
+	BenchmarkOptions options;
+	options.sizes = { 10000, 100000, 1000000 };
+	options.workers = { 1, 2, 4, 8 };
+	harness.Run(options);
+}
+
+
 int main()
 {
-	srand((unsigned)time(0));
+	const unsigned long long seed = static_cast<unsigned long long>(time(0));
+
+	if (MICROBENCHMARK_MODE)
+	{
+		RunMicrobenchmarks(seed);
+		return 0;
+	}
 
 	//     = 4
 	__cilkrts_set_param("nworkers", "4");
 
 	constexpr long mass_size = 1000000;
 
-	printf("\nNumber of elements in array = %d\n\n", mass_size);
+	printf("\nNumber of elements in array = %ld\n\n", mass_size);
 	int *mass = new int[mass_size];
-	for (long i = 0; i < mass_size; ++i)
-	{
-		mass[i] = (rand() % 25000) + 1;
-	}
+	ParallelFillUniformInt(mass, mass_size, PhiloxRng(seed), 1, 25000);
 
 	int *mass_begin = mass;
 	int *mass_end = mass_begin + mass_size;
@@ -119,9 +691,11 @@ int main()
 	//    
 	ReducerMaxTest(mass, mass_size);
 	ReducerMinTest(mass, mass_size);
+	MinMaxTest(mass, mass_size, false);
 
 	//    
 	printf("\nSome sorting is happening!\n");
+	const std::vector<int> random_input(mass_begin, mass_end);
 
 	high_resolution_clock::time_point t1 = high_resolution_clock::now();
 	ParallelSort(mass_begin, mass_end);
@@ -133,6 +707,17 @@ int main()
 	//    
 	ReducerMaxTest(mass, mass_size);
 	ReducerMinTest(mass, mass_size);
+	MinMaxTest(mass, mass_size, true);
+
+	//  ,          
+	printf("\n");
+	SortBenchmark("Random", random_input);
+	std::vector<int> input(mass_begin, mass_end);
+	SortBenchmark("Sorted", input);
+	std::reverse(input.begin(), input.end());
+	SortBenchmark("Reverse sorted", input);
+	std::fill(input.begin(), input.end(), 1);
+	SortBenchmark("All equal", input);
 
 	delete[] mass;
 	return 0;
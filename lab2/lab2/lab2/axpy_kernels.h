@@ -0,0 +1,260 @@
+﻿#pragma once
+
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Intel C++ и MSVC разрешают векторные инструкции в любой функции,
+// GCC и Clang требуют явно указать набор инструкций для функции
+#if defined(__GNUC__) && !defined(__INTEL_COMPILER)
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define KERNEL_TARGET(isa)
+#endif
+
+/// тип ядра y[0..n) += a * x[0..n); строки y и x не должны пересекаться
+using AxpyKernel = void (*)(double* __restrict y, const double* __restrict x, double a, int n);
+/// то же для одинарной точности
+using AxpyKernelF = void (*)(float* __restrict y, const float* __restrict x, float a, int n);
+
+/// Функция AxpyScalar() - скалярная версия ядра, используется
+/// как эталон и на процессорах без SSE2
+inline void AxpyScalar(double* __restrict y, const double* __restrict x, const double a, const int n)
+{
+    for (int j = 0; j < n; ++j)
+    {
+        y[j] += a * x[j];
+    }
+}
+
+inline void AxpyScalar(float* __restrict y, const float* __restrict x, const float a, const int n)
+{
+    for (int j = 0; j < n; ++j)
+    {
+        y[j] += a * x[j];
+    }
+}
+
+/// Функция AxpySse2() - ядро на SSE2, по 2 элемента за инструкцию
+KERNEL_TARGET("sse2")
+inline void AxpySse2(double* __restrict y, const double* __restrict x, const double a, const int n)
+{
+    const __m128d va = _mm_set1_pd(a);
+    int j = 0;
+    for (; j + 4 <= n; j += 4)
+    {
+        __m128d y0 = _mm_loadu_pd(y + j);
+        __m128d y1 = _mm_loadu_pd(y + j + 2);
+        y0 = _mm_add_pd(y0, _mm_mul_pd(va, _mm_loadu_pd(x + j)));
+        y1 = _mm_add_pd(y1, _mm_mul_pd(va, _mm_loadu_pd(x + j + 2)));
+        _mm_storeu_pd(y + j, y0);
+        _mm_storeu_pd(y + j + 2, y1);
+    }
+    for (; j < n; ++j)
+    {
+        y[j] += a * x[j];
+    }
+}
+
+KERNEL_TARGET("sse2")
+inline void AxpySse2(float* __restrict y, const float* __restrict x, const float a, const int n)
+{
+    const __m128 va = _mm_set1_ps(a);
+    int j = 0;
+    for (; j + 8 <= n; j += 8)
+    {
+        __m128 y0 = _mm_loadu_ps(y + j);
+        __m128 y1 = _mm_loadu_ps(y + j + 4);
+        y0 = _mm_add_ps(y0, _mm_mul_ps(va, _mm_loadu_ps(x + j)));
+        y1 = _mm_add_ps(y1, _mm_mul_ps(va, _mm_loadu_ps(x + j + 4)));
+        _mm_storeu_ps(y + j, y0);
+        _mm_storeu_ps(y + j + 4, y1);
+    }
+    for (; j < n; ++j)
+    {
+        y[j] += a * x[j];
+    }
+}
+
+/// Функция AxpyAvx2() - ядро на AVX2 + FMA, по 4 элемента за инструкцию
+KERNEL_TARGET("avx2,fma")
+inline void AxpyAvx2(double* __restrict y, const double* __restrict x, const double a, const int n)
+{
+    const __m256d va = _mm256_set1_pd(a);
+    int j = 0;
+    for (; j + 8 <= n; j += 8)
+    {
+        const __m256d y0 = _mm256_fmadd_pd(va, _mm256_loadu_pd(x + j), _mm256_loadu_pd(y + j));
+        const __m256d y1 = _mm256_fmadd_pd(va, _mm256_loadu_pd(x + j + 4), _mm256_loadu_pd(y + j + 4));
+        _mm256_storeu_pd(y + j, y0);
+        _mm256_storeu_pd(y + j + 4, y1);
+    }
+    for (; j < n; ++j)
+    {
+        y[j] += a * x[j];
+    }
+}
+
+KERNEL_TARGET("avx2,fma")
+inline void AxpyAvx2(float* __restrict y, const float* __restrict x, const float a, const int n)
+{
+    const __m256 va = _mm256_set1_ps(a);
+    int j = 0;
+    for (; j + 16 <= n; j += 16)
+    {
+        const __m256 y0 = _mm256_fmadd_ps(va, _mm256_loadu_ps(x + j), _mm256_loadu_ps(y + j));
+        const __m256 y1 = _mm256_fmadd_ps(va, _mm256_loadu_ps(x + j + 8), _mm256_loadu_ps(y + j + 8));
+        _mm256_storeu_ps(y + j, y0);
+        _mm256_storeu_ps(y + j + 8, y1);
+    }
+    for (; j < n; ++j)
+    {
+        y[j] += a * x[j];
+    }
+}
+
+/// Функция AxpyAvx512() - ядро на AVX-512F, по 8 элементов за инструкцию;
+/// хвост обрабатывается маскированными операциями
+KERNEL_TARGET("avx512f")
+inline void AxpyAvx512(double* __restrict y, const double* __restrict x, const double a, const int n)
+{
+    const __m512d va = _mm512_set1_pd(a);
+    int j = 0;
+    for (; j + 16 <= n; j += 16)
+    {
+        const __m512d y0 = _mm512_fmadd_pd(va, _mm512_loadu_pd(x + j), _mm512_loadu_pd(y + j));
+        const __m512d y1 = _mm512_fmadd_pd(va, _mm512_loadu_pd(x + j + 8), _mm512_loadu_pd(y + j + 8));
+        _mm512_storeu_pd(y + j, y0);
+        _mm512_storeu_pd(y + j + 8, y1);
+    }
+    for (; j < n; j += 8)
+    {
+        const __mmask8 mask = static_cast<__mmask8>(n - j >= 8 ? 0xFF : (1u << (n - j)) - 1);
+        const __m512d yv = _mm512_maskz_loadu_pd(mask, y + j);
+        const __m512d xv = _mm512_maskz_loadu_pd(mask, x + j);
+        _mm512_mask_storeu_pd(y + j, mask, _mm512_fmadd_pd(va, xv, yv));
+    }
+}
+
+KERNEL_TARGET("avx512f")
+inline void AxpyAvx512(float* __restrict y, const float* __restrict x, const float a, const int n)
+{
+    const __m512 va = _mm512_set1_ps(a);
+    int j = 0;
+    for (; j + 32 <= n; j += 32)
+    {
+        const __m512 y0 = _mm512_fmadd_ps(va, _mm512_loadu_ps(x + j), _mm512_loadu_ps(y + j));
+        const __m512 y1 = _mm512_fmadd_ps(va, _mm512_loadu_ps(x + j + 16), _mm512_loadu_ps(y + j + 16));
+        _mm512_storeu_ps(y + j, y0);
+        _mm512_storeu_ps(y + j + 16, y1);
+    }
+    for (; j < n; j += 16)
+    {
+        const __mmask16 mask = static_cast<__mmask16>(n - j >= 16 ? 0xFFFF : (1u << (n - j)) - 1);
+        const __m512 yv = _mm512_maskz_loadu_ps(mask, y + j);
+        const __m512 xv = _mm512_maskz_loadu_ps(mask, x + j);
+        _mm512_mask_storeu_ps(y + j, mask, _mm512_fmadd_ps(va, xv, yv));
+    }
+}
+
+/// перечисление наборов инструкций, для которых есть версии ядра
+enum class esimd_isa
+{
+    scalar = 0,
+    sse2,
+    avx2,
+    avx512
+};
+
+/// Функция DetectSimdIsa() определяет по CPUID наилучший набор инструкций,
+/// поддерживаемый процессором и операционной системой
+inline esimd_isa DetectSimdIsa()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    const int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+
+    // ОС должна сохранять регистры YMM (биты 1-2) и ZMM (биты 5-7) при переключении задач
+    const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    const bool os_avx = (xcr0 & 0x6) == 0x6;
+    const bool os_avx512 = (xcr0 & 0xE6) == 0xE6;
+
+    bool avx2 = false;
+    bool avx512f = false;
+    if (max_leaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+        avx512f = (info[1] & (1 << 16)) != 0;
+    }
+
+    if (avx512f && os_avx512)
+    {
+        return esimd_isa::avx512;
+    }
+    if (avx2 && fma && os_avx)
+    {
+        return esimd_isa::avx2;
+    }
+    return sse2 ? esimd_isa::sse2 : esimd_isa::scalar;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return esimd_isa::avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return esimd_isa::avx2;
+    }
+    return __builtin_cpu_supports("sse2") ? esimd_isa::sse2 : esimd_isa::scalar;
+#endif
+}
+
+/// Функция SimdIsaName() возвращает название набора инструкций для вывода
+inline const char* SimdIsaName(const esimd_isa isa)
+{
+    switch (isa)
+    {
+    case esimd_isa::avx512: return "AVX-512";
+    case esimd_isa::avx2: return "AVX2";
+    case esimd_isa::sse2: return "SSE2";
+    default: return "scalar";
+    }
+}
+
+/// Функция SelectAxpyKernel() возвращает версию ядра для набора инструкций <i>isa</i>;
+/// Kernel - тип ядра (AxpyKernel или AxpyKernelF) определяет точность
+template <typename Kernel>
+inline Kernel SelectAxpyKernel(const esimd_isa isa)
+{
+    switch (isa)
+    {
+    case esimd_isa::avx512: return AxpyAvx512;
+    case esimd_isa::avx2: return AxpyAvx2;
+    case esimd_isa::sse2: return AxpySse2;
+    default: return AxpyScalar;
+    }
+}
+
+/// Функция Axpy() выполняет y[0..n) += a * x[0..n) ядром, выбранным
+/// по CPUID при первом вызове; выбор кэшируется на всё время работы
+inline void Axpy(double* __restrict y, const double* __restrict x, const double a, const int n)
+{
+    static const AxpyKernel kernel = SelectAxpyKernel<AxpyKernel>(DetectSimdIsa());
+    kernel(y, x, a, n);
+}
+
+inline void Axpy(float* __restrict y, const float* __restrict x, const float a, const int n)
+{
+    static const AxpyKernelF kernel = SelectAxpyKernel<AxpyKernelF>(DetectSimdIsa());
+    kernel(y, x, a, n);
+}
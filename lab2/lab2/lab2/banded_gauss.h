@@ -0,0 +1,480 @@
+﻿#pragma once
+
+#include <cilk/cilk.h>
+#include <cilk/cilk_api.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "../../../common/aligned_matrix.h"
+#include "axpy_kernels.h"
+
+// минимальный объем работы (строки x столбцы) шага исключения в ленточной
+// матрице, начиная с которого строки шага обновляются параллельно; для узких лент
+// шаг слишком мал, и параллельность дает разбиение ленты на части
+constexpr int BAND_PARALLEL_WORK = 16384;
+// количество частей ленты на одного исполнителя при разбиении и наименьшая
+// высота части в ширинах ленты (lower + upper)
+constexpr int BAND_PARTITIONS_PER_WORKER = 4;
+constexpr int BAND_MIN_PARTITION_SPANS = 64;
+// наименьшее количество исполнителей, при котором ленту выгодно разбивать: на одном
+// исполнителе решение по частям (100000 строк, полуширина 8, 16 частей) занимает
+// примерно вдвое больше времени, чем последовательное
+constexpr int BAND_MIN_WORKERS = 4;
+
+/// Класс BandMatrix хранит ленточную матрицу с <i>lower</i> диагоналями
+/// под главной и <i>upper</i> над ней. Каждая строка хранится непрерывно,
+/// элемент (i, j) лежит в row(i)[j - i + lower()]. Ширина строки включает
+/// еще <i>lower</i> диагоналей сверху под заполнение при выборе ведущего
+/// элемента, поэтому память занимает O(rows * (2 * lower + upper + 1)).
+class BandMatrix
+{
+public:
+    BandMatrix(const int rows, const int lower, const int upper)
+        : rows_(rows), lower_(lower), upper_(upper),
+          data_(rows, 2 * lower + upper + 1)
+    {
+        const size_t width = data_.cols();
+        cilk_for (int i = 0; i < rows; ++i)
+        {
+            std::memset(data_[i], 0, width * sizeof(double));
+        }
+    }
+
+    /// Функция at() возвращает элемент (i, j); j должен лежать в ленте строки i
+    double& at(const int i, const int j) { return data_[i][j - i + lower_]; }
+    double at(const int i, const int j) const { return data_[i][j - i + lower_]; }
+
+    double* row(const int i) { return data_[i]; }
+    const double* row(const int i) const { return data_[i]; }
+
+    int rows() const { return rows_; }
+    int lower() const { return lower_; }
+    int upper() const { return upper_; }
+    int width() const { return static_cast<int>(data_.cols()); }
+
+private:
+    int rows_;
+    int lower_;
+    int upper_;
+    AlignedMatrix<double> data_;
+};
+
+
+/// Функция BandedSolve() решает СЛАУ с ленточной матрицей и nrhs правыми частями
+/// методом Гаусса с частичным выбором ведущего элемента. Каждый шаг исключения
+/// затрагивает только <i>lower</i> строк под диагональю и <i>lower + upper</i> столбцов
+/// справа, поэтому решение занимает O(n * lower * (lower + upper + nrhs)) вместо O(n^3).
+/// Строки шага обновляются параллельно, если объем работы шага превышает BAND_PARALLEL_WORK.
+/// band - ленточная матрица; после вызова содержит верхнюю треугольную матрицу
+/// rhs - правые части, массив rows x nrhs по строкам; после вызова содержит решения
+/// nrhs - количество правых частей
+/// tail - количество последних правых частей, равных нулю в строках выше tail_first_row:
+/// пока шаг исключения не достает до этих строк, такие правые части не обновляются
+inline void BandedSolve(BandMatrix& band, double* rhs, const int nrhs, const int tail = 0, const int tail_first_row = 0)
+{
+    const int rows = band.rows();
+    const int kl = band.lower();
+    const int span = band.lower() + band.upper();
+
+    for (int k = 0; k < rows; ++k)
+    {
+        const int last = std::min(k + kl, rows - 1);
+
+        // выбор ведущего элемента среди строк, пересекающихся со столбцом k
+        int pivot = k;
+        for (int i = k + 1; i <= last; ++i)
+        {
+            if (std::fabs(band.at(i, k)) > std::fabs(band.at(pivot, k)))
+            {
+                pivot = i;
+            }
+        }
+
+        if (band.at(pivot, k) == 0.0)
+        {
+            throw std::runtime_error("Matrix is singular: zero pivot column in banded Gauss method");
+        }
+
+        // перестановка строк со сдвигом: ненулевые элементы обеих строк лежат
+        // в столбцах [k, k + span], которые помещаются в ленту каждой из них
+        const int jmax = std::min(k + span, rows - 1);
+        const int active = k + kl < tail_first_row ? nrhs - tail : nrhs;
+        if (pivot != k)
+        {
+            for (int j = k; j <= jmax; ++j)
+            {
+                std::swap(band.at(k, j), band.at(pivot, j));
+            }
+            std::swap_ranges(rhs + k * nrhs, rhs + k * nrhs + active, rhs + pivot * nrhs);
+        }
+
+        const double* row_k = band.row(k) + kl;
+        const double* rhs_k = rhs + k * nrhs;
+        const int count = jmax - k;
+
+        auto eliminate_row = [&](const int i)
+        {
+            double* row_i = band.row(i) + (k - i + kl);
+            double* rhs_i = rhs + i * nrhs;
+            const double koef = row_i[0] / row_k[0];
+
+            row_i[0] = 0.0;
+            Axpy(row_i + 1, row_k + 1, -koef, count);
+            for (int c = 0; c < active; ++c)
+            {
+                rhs_i[c] -= koef * rhs_k[c];
+            }
+        };
+
+        if ((last - k) * (count + active) >= BAND_PARALLEL_WORK)
+        {
+            cilk_for (int i = k + 1; i <= last; ++i)
+            {
+                eliminate_row(i);
+            }
+        }
+        else
+        {
+            for (int i = k + 1; i <= last; ++i)
+            {
+                eliminate_row(i);
+            }
+        }
+    }
+
+    // обратный ход: в строке i ненулевые элементы лежат в столбцах [i, i + span]
+    for (int i = rows - 1; i >= 0; --i)
+    {
+        const double* row_i = band.row(i) + kl;
+        const int count = std::min(span, rows - 1 - i);
+        double* rhs_i = rhs + i * nrhs;
+
+        for (int j = 1; j <= count; ++j)
+        {
+            const double u = row_i[j];
+            const double* rhs_j = rhs + (i + j) * nrhs;
+            for (int c = 0; c < nrhs; ++c)
+            {
+                rhs_i[c] -= u * rhs_j[c];
+            }
+        }
+
+        for (int c = 0; c < nrhs; ++c)
+        {
+            rhs_i[c] /= row_i[0];
+        }
+    }
+}
+
+
+/// Функция PartitionedBandedGaussMethod() решает СЛАУ с ленточной матрицей по частям
+/// (алгоритм SPIKE). Строки делятся на <i>partitions</i> частей A_j, которые решаются
+/// параллельно и независимо, каждая с выбором ведущего элемента внутри себя:
+/// кроме правой части f_j находятся "шипы" V_j = A_j^-1 [0; B_j] и W_j = A_j^-1 [C_j; 0],
+/// где B_j и C_j - элементы ленты, связывающие часть с соседними. Тогда
+/// x_j = g_j - V_j * (первые upper неизвестных части j + 1) - W_j * (последние lower неизвестных части j - 1),
+/// и из верхних upper и нижних lower строк каждой части получается малая ленточная
+/// система на неизвестные на границах частей; она решается последовательно, после чего
+/// неизвестные всех частей восстанавливаются параллельно.
+/// Каждая часть должна содержать не меньше lower + upper строк; если при отдельном
+/// решении часть оказалась вырожденной, бросается std::runtime_error
+/// band - ленточная матрица (не меняется)
+/// rhs - правые части
+/// result - массив ответов СЛАУ
+/// partitions - количество частей
+inline void PartitionedBandedGaussMethod(const BandMatrix& band, const double* rhs, double* result, const int partitions)
+{
+    const int rows = band.rows();
+    const int kl = band.lower();
+    const int ku = band.upper();
+    const int span = kl + ku;
+    const int nrhs = 1 + ku + kl;
+
+    // решения частей: столбец 0 - g_j, столбцы 1..kl - W_j, остальные ku - V_j;
+    // правые части V_j отличны от нуля только в последних ku строках части
+    std::vector<std::vector<double>> spikes(partitions);
+
+    cilk_for (int p = 0; p < partitions; ++p)
+    {
+        const int first = static_cast<int>(static_cast<long long>(p) * rows / partitions);
+        const int last = static_cast<int>(static_cast<long long>(p + 1) * rows / partitions);
+        const int size = last - first;
+
+        BandMatrix block(size, kl, ku);
+        std::vector<double>& solution = spikes[p];
+        solution.assign(static_cast<size_t>(size) * nrhs, 0.0);
+
+        for (int i = first; i < last; ++i)
+        {
+            double* rhs_i = &solution[static_cast<size_t>(i - first) * nrhs];
+            rhs_i[0] = rhs[i];
+
+            for (int j = std::max(i - kl, 0); j <= std::min(i + ku, rows - 1); ++j)
+            {
+                if (j < first)
+                {
+                    rhs_i[1 + j - (first - kl)] = band.at(i, j);
+                }
+                else if (j >= last)
+                {
+                    rhs_i[1 + kl + j - last] = band.at(i, j);
+                }
+                else
+                {
+                    block.at(i - first, j - first) = band.at(i, j);
+                }
+            }
+        }
+
+        BandedSolve(block, solution.data(), nrhs, ku, size - ku);
+    }
+
+    // неизвестные на границах: у части j сначала первые ku, затем последние kl
+    const int reduced_rows = partitions * span;
+    BandMatrix reduced(reduced_rows, 2 * kl + ku, 2 * ku + kl);
+    std::vector<double> boundary(reduced_rows);
+
+    for (int p = 0; p < partitions; ++p)
+    {
+        const int size = static_cast<int>(spikes[p].size()) / nrhs;
+
+        for (int r = 0; r < span; ++r)
+        {
+            const int row = p * span + r;
+            const double* solution_r = &spikes[p][static_cast<size_t>(r < ku ? r : size - span + r) * nrhs];
+
+            reduced.at(row, row) = 1.0;
+            boundary[row] = solution_r[0];
+            for (int c = 0; c < ku && p + 1 < partitions; ++c)
+            {
+                reduced.at(row, (p + 1) * span + c) = solution_r[1 + kl + c];
+            }
+            for (int c = 0; c < kl && p > 0; ++c)
+            {
+                reduced.at(row, (p - 1) * span + ku + c) = solution_r[1 + c];
+            }
+        }
+    }
+
+    BandedSolve(reduced, boundary.data(), 1);
+
+    cilk_for (int p = 0; p < partitions; ++p)
+    {
+        const int first = static_cast<int>(static_cast<long long>(p) * rows / partitions);
+        const int size = static_cast<int>(spikes[p].size()) / nrhs;
+        const double* next_top = p + 1 < partitions ? &boundary[(p + 1) * span] : nullptr;
+        const double* prev_bottom = p > 0 ? &boundary[(p - 1) * span + ku] : nullptr;
+
+        for (int i = 0; i < size; ++i)
+        {
+            const double* solution_i = &spikes[p][static_cast<size_t>(i) * nrhs];
+            double x = solution_i[0];
+            for (int c = 0; c < ku && next_top != nullptr; ++c)
+            {
+                x -= solution_i[1 + kl + c] * next_top[c];
+            }
+            for (int c = 0; c < kl && prev_bottom != nullptr; ++c)
+            {
+                x -= solution_i[1 + c] * prev_bottom[c];
+            }
+            result[first + i] = x;
+        }
+    }
+}
+
+
+/// Функция BandPartitions() возвращает количество частей, на которые выгодно разбить
+/// ленту при текущем количестве исполнителей: 1, если исполнителей меньше
+/// BAND_MIN_WORKERS или части получились бы ниже BAND_MIN_PARTITION_SPANS ширин ленты
+inline int BandPartitions(const int rows, const int lower, const int upper)
+{
+    const int workers = __cilkrts_get_nworkers();
+    if (workers < BAND_MIN_WORKERS)
+    {
+        return 1;
+    }
+
+    const long long min_rows = static_cast<long long>(BAND_MIN_PARTITION_SPANS) * std::max(lower + upper, 1);
+    return static_cast<int>(std::max(1LL, std::min<long long>(workers * BAND_PARTITIONS_PER_WORKER, rows / min_rows)));
+}
+
+
+/// Функция BandedGaussMethod() решает СЛАУ с ленточной матрицей: при разбиении
+/// BandPartitions() больше чем на одну часть - по частям PartitionedBandedGaussMethod(),
+/// иначе (и если часть оказалась вырожденной) - целиком последовательным BandedSolve()
+/// band - ленточная матрица; после последовательного решения содержит верхнюю треугольную матрицу
+/// rhs - правые части
+/// result - массив ответов СЛАУ
+/// Возвращает количество частей, на которые была разбита лента
+inline int BandedGaussMethod(BandMatrix& band, const double* rhs, double* result)
+{
+    const int partitions = BandPartitions(band.rows(), band.lower(), band.upper());
+    if (partitions > 1)
+    {
+        try
+        {
+            PartitionedBandedGaussMethod(band, rhs, result, partitions);
+            return partitions;
+        }
+        catch (const std::runtime_error&)
+        {
+            // часть ленты вырождена без строк соседних частей - решаем ленту целиком
+        }
+    }
+
+    std::copy(rhs, rhs + band.rows(), result);
+    BandedSolve(band, result, 1);
+    return 1;
+}
+
+
+/// Структура SparseMatrix хранит разреженную квадратную матрицу
+/// в формате CSR: элементы строки i лежат в values[row_ptr[i]..row_ptr[i + 1]),
+/// их номера столбцов - в col_idx
+struct SparseMatrix
+{
+    int rows = 0;
+    std::vector<int> row_ptr;
+    std::vector<int> col_idx;
+    std::vector<double> values;
+};
+
+
+/// Функция ReverseCuthillMcKee() строит упорядочение обратным алгоритмом
+/// Катхилла-Макки по симметризованному портрету матрицы; упорядочение
+/// уменьшает ширину ленты, а с ней и заполнение при исключении
+/// Возвращает order: order[new] - исходный номер строки и столбца
+inline std::vector<int> ReverseCuthillMcKee(const SparseMatrix& matrix)
+{
+    const int rows = matrix.rows;
+
+    // портрет A + A^T без диагонали
+    std::vector<std::vector<int>> adjacency(rows);
+    for (int i = 0; i < rows; ++i)
+    {
+        for (int p = matrix.row_ptr[i]; p < matrix.row_ptr[i + 1]; ++p)
+        {
+            const int j = matrix.col_idx[p];
+            if (j != i)
+            {
+                adjacency[i].push_back(j);
+                adjacency[j].push_back(i);
+            }
+        }
+    }
+
+    std::vector<int> degree(rows);
+    for (int i = 0; i < rows; ++i)
+    {
+        std::sort(adjacency[i].begin(), adjacency[i].end());
+        adjacency[i].erase(std::unique(adjacency[i].begin(), adjacency[i].end()), adjacency[i].end());
+        degree[i] = static_cast<int>(adjacency[i].size());
+    }
+
+    auto by_degree = [&](const int a, const int b) { return degree[a] < degree[b]; };
+
+    std::vector<int> order;
+    order.reserve(rows);
+    std::vector<bool> visited(rows, false);
+
+    // обход в ширину от вершины наименьшей степени в каждой компоненте связности
+    std::vector<int> candidates(rows);
+    for (int i = 0; i < rows; ++i)
+    {
+        candidates[i] = i;
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), by_degree);
+
+    std::vector<int> neighbours;
+    for (const int start : candidates)
+    {
+        if (visited[start])
+        {
+            continue;
+        }
+
+        visited[start] = true;
+        size_t head = order.size();
+        order.push_back(start);
+
+        while (head < order.size())
+        {
+            const int v = order[head++];
+
+            neighbours.clear();
+            for (const int u : adjacency[v])
+            {
+                if (!visited[u])
+                {
+                    visited[u] = true;
+                    neighbours.push_back(u);
+                }
+            }
+            std::stable_sort(neighbours.begin(), neighbours.end(), by_degree);
+            order.insert(order.end(), neighbours.begin(), neighbours.end());
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+
+/// Функция SparseGaussMethod() решает СЛАУ с разреженной матрицей: строки и
+/// столбцы переупорядочиваются ReverseCuthillMcKee(), переставленная матрица
+/// переносится в ленточный формат с полученной шириной ленты и решается
+/// BandedGaussMethod()
+/// matrix - разреженная матрица СЛАУ
+/// rhs - правые части
+/// result - массив ответов СЛАУ
+/// Возвращает ширину ленты (max из нижней и верхней) после переупорядочения
+inline int SparseGaussMethod(const SparseMatrix& matrix, const double* rhs, double* result)
+{
+    const int rows = matrix.rows;
+    const std::vector<int> order = ReverseCuthillMcKee(matrix);
+
+    std::vector<int> position(rows);
+    for (int i = 0; i < rows; ++i)
+    {
+        position[order[i]] = i;
+    }
+
+    int lower = 0;
+    int upper = 0;
+    for (int i = 0; i < rows; ++i)
+    {
+        for (int p = matrix.row_ptr[i]; p < matrix.row_ptr[i + 1]; ++p)
+        {
+            const int offset = position[matrix.col_idx[p]] - position[i];
+            lower = std::max(lower, -offset);
+            upper = std::max(upper, offset);
+        }
+    }
+
+    BandMatrix band(rows, lower, upper);
+    std::vector<double> band_rhs(rows);
+    std::vector<double> band_result(rows);
+
+    cilk_for (int i = 0; i < rows; ++i)
+    {
+        const int row = order[i];
+        for (int p = matrix.row_ptr[row]; p < matrix.row_ptr[row + 1]; ++p)
+        {
+            band.at(i, position[matrix.col_idx[p]]) += matrix.values[p];
+        }
+        band_rhs[i] = rhs[row];
+    }
+
+    BandedGaussMethod(band, band_rhs.data(), band_result.data());
+
+    cilk_for (int i = 0; i < rows; ++i)
+    {
+        result[order[i]] = band_result[i];
+    }
+
+    return std::max(lower, upper);
+}
@@ -2,6 +2,7 @@
 #include <ctime>
 #include <cilk/cilk.h>
 #include <cilk/reducer_opadd.h>
+#include <cilk/reducer_max.h>
 #include <chrono>
 
 
@@ -10,40 +11,119 @@
 #include <cilk/reducer_list.h>
 #include <cilk/reducer.h>
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdarg>
+#include <string>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "../../../common/aligned_matrix.h"
+#include "../../../common/benchmark.h"
+#include "../../../common/counter_rng.h"
+#include "../../../common/deterministic_sum.h"
+#include "axpy_kernels.h"
+#include "banded_gauss.h"
+
 using namespace std::chrono;
 
+//          stride()
+using Matrix = AlignedMatrix<double>;
+
 //      
 constexpr int MATRIX_SIZE = 3000;
 //     
 constexpr bool TEST_MODE = false;
+//     BenchmarkHarness:   
+//  CSV (, p95, GFLOP/s, ,  )
+constexpr bool BENCHMARK_MODE = false;
+//         
+constexpr bool PARTIAL_PIVOTING = true;
+//   ( ),      
+constexpr int PANEL_SIZE = 64;
+//  ,      ;
+//    (PANEL_SIZE x TILE_COLS)     L2
+constexpr int TILE_ROWS = 64;
+constexpr int TILE_COLS = 256;
+//         
+constexpr bool LOOKAHEAD = true;
+//           
+//      
+constexpr int BACK_SUBST_BLOCK = 256;
+constexpr int BACK_SUBST_ROWS = 128;
+//     ,     
+//   (     cilk_for)
+constexpr int BACK_SUBST_CUTOFF = 1024;
+//        
+constexpr int MAX_REFINEMENT_STEPS = 10;
+//        
+constexpr int BAND_MATRIX_SIZE = 100000;
+constexpr int BAND_HALF_WIDTH = 8;
+//       ( ,  )
+constexpr int SPARSE_GRID_SIZE = 100;
+//  ,         ;
+//      1 -    
+constexpr int BENCHMARK_SIZES[] = { 250, 500, 1000, 2000 };
+constexpr int BENCHMARK_WORKERS[] = { 1, 2, 4, 8 };
+constexpr int BENCHMARK_REPEATS = 5;
+//   ,      
+constexpr int RHS_TILE = 64;
+//         LU-
+constexpr int RHS_COUNT = 256;
 
 namespace
 {
     //       
     duration<double> serialDuration{};
     duration<double> parallelDuration{};
+    duration<double> blockedDuration{};
+    //       (    
+    // ),          
+    duration<double> mixedDuration{};
+    int mixedSteps = 0;
+    bool mixedFallback = false;
+    duration<double> factorDuration{};
+    duration<double> solveDuration{};
+    //       (   )
+    bool verboseOutput = true;
+    //     :   
+    //        
+    unsigned long long randomSeed = 0;
+}
+
+///  Report()    ,   
+/// (   printf)
+void Report(const char* format, ...)
+{
+    if (verboseOutput)
+    {
+        va_list args;
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
+    }
 }
 
 ///  InitMatrix()     
-///     
+///     ;
+///       .
+///  (i, j) -      i * cols + j
+///  randomSeed,    
 /// matrix -   
-void InitMatrix( double** matrix )
+void InitMatrix( Matrix& matrix )
 {
-	for ( int i = 0; i < MATRIX_SIZE; ++i )
-	{
-		matrix[i] = new double[MATRIX_SIZE + 1];
-	}
+	const PhiloxRng rng(randomSeed);
+	const long long cols = static_cast<long long>(matrix.cols());
 
-	for ( int i = 0; i < MATRIX_SIZE; ++i )
+	cilk_for ( size_t i = 0; i < matrix.rows(); ++i )
 	{
-		for ( int j = 0; j <= MATRIX_SIZE; ++j )
-		{
-			matrix[i][j] = rand() % 2500 + 1;
-		}
+		FillUniformInt(matrix[i], i * cols, cols, rng, 1, 2500);
 	}
 }
 
-void InitTestMatrix(double** test_matrix)
+void InitTestMatrix(Matrix& test_matrix)
 {
     //   
     test_matrix[0][0] = 2; test_matrix[0][1] = 5;  test_matrix[0][2] = 4;  test_matrix[0][3] = 1;  test_matrix[0][4] = 20;
@@ -52,7 +132,7 @@ void InitTestMatrix(double** test_matrix)
     test_matrix[3][0] = 3; test_matrix[3][1] = 8;  test_matrix[3][2] = 9;  test_matrix[3][3] = 2;  test_matrix[3][4] = 37;
 }
 
-void InitMainMatrix(double** matrix)
+void InitMainMatrix(Matrix& matrix)
 {
     if (TEST_MODE)
     {
@@ -64,33 +144,53 @@ void InitMainMatrix(double** matrix)
     }
 }
 
+///  GaussFlops()     
+///   (~2/3 * rows^3)
+/// rows -     
+double GaussFlops(const int rows)
+{
+    return 2.0 / 3.0 * rows * static_cast<double>(rows) * rows;
+}
+
+///  GaussGflops()    
+///    GFLOP/s
+/// rows -     
+/// forward_duration -   
+double GaussGflops(const int rows, const duration<double>& forward_duration)
+{
+    return GaussFlops(rows) / forward_duration.count() * 1e-9;
+}
+
+
 ///  SerialGaussMethod()     
 /// matrix -    ,   ,
 ///    -    
 /// rows -     
 /// result -   
-void SerialGaussMethod( double **matrix, const int rows, double* result )
+void SerialGaussMethod( Matrix& matrix, const int rows, double* result )
 {
     high_resolution_clock::time_point t1 = high_resolution_clock::now();
 	//    
 	for ( int k = 0; k < rows; ++k )
 	{
 		//
+		const double* row_k = matrix[k];
+
 		for ( int i = k + 1; i < rows; ++i )
 		{
-            double koef = -matrix[i][k] / matrix[k][k];
+            double* row_i = matrix[i];
+            double koef = -row_i[k] / row_k[k];
 
-			for ( int j = k; j <= rows; ++j )
-			{
-				matrix[i][j] += koef * matrix[k][j];
-			}
+			Axpy(row_i + k, row_k + k, koef, rows + 1 - k);
 		}
 	}
     high_resolution_clock::time_point t2 = high_resolution_clock::now();
     serialDuration = (t2 - t1);
-    printf("Serial forward Gauss time - %f \n", serialDuration.count());
+    Report("Serial forward Gauss time - %f (%f GFLOP/s) \n",
+        serialDuration.count(), GaussGflops(rows, serialDuration));
 
 	//    
+	t1 = high_resolution_clock::now();
 	result[rows - 1] = matrix[rows - 1][rows] / matrix[rows - 1][rows - 1];
 
 	for ( int k = rows - 2; k >= 0; --k )
@@ -105,74 +205,901 @@ void SerialGaussMethod( double **matrix, const int rows, double* result )
 
 		result[k] /= matrix[k][k];
 	}
+	t2 = high_resolution_clock::now();
+	Report("Serial back substitution time - %f \n", duration<double>(t2 - t1).count());
+}
+
+
+///  FindPivotRow()     <i>k</i>  
+/// k..rows-1          ;
+///    ,     
+/// matrix -  
+/// perm -  : perm[i] -     i
+/// k -   (   )
+/// rows -    
+template <typename T>
+int FindPivotRow(const AlignedMatrix<T>& matrix, const std::vector<int>& perm, const int k, const int rows)
+{
+    cilk::reducer<cilk::op_max_index<int, T>> pivot;
+    cilk_for (int i = k; i < rows; ++i)
+    {
+        pivot->calc_max(i, std::abs(matrix[perm[i]][k]));
+    }
+
+    if (pivot->get_reference() == T(0))
+    {
+        throw std::runtime_error("Matrix is singular: zero pivot column in Gauss method");
+    }
+    return pivot->get_index_reference();
+}
+
+
+///  BackSubstitution()       
+///  .     BACK_SUBST_BLOCK  :
+///    ,    
+///         
+///   - ,      BACK_SUBST_CUTOFF 
+///    .    
+///  CompensatedSum(),        :
+///         ,
+///        .
+/// matrix -    ,   -  
+/// perm -  : perm[i] -     i
+/// rows -    
+/// result -   
+void BackSubstitution(const Matrix& matrix, const std::vector<int>& perm, const int rows, double* result)
+{
+    for (int i = 0; i < rows; ++i)
+    {
+        result[i] = matrix[perm[i]][rows];
+    }
+
+    const bool parallel = __cilkrts_get_nworkers() > 1;
+    for (int iend = rows; iend > 0; iend -= BACK_SUBST_BLOCK)
+    {
+        const int ib = std::max(iend - BACK_SUBST_BLOCK, 0);
+
+        //  
+        for (int k = iend - 1; k >= ib; --k)
+        {
+            const double* row_k = matrix[perm[k]];
+            NeumaierSum sum(result[k]);
+            sum.add(CompensatedSum(k + 1, iend, [row_k, result](const long long j) { return -row_k[j] * result[j]; }));
+
+            result[k] = sum.value() / row_k[k];
+        }
+
+        //  : result[0..ib) -= U[0..ib, ib..iend) * x[ib..iend)
+        auto update_rows = [&](const int rb, const int rend)
+        {
+            for (int r = rb; r < rend; ++r)
+            {
+                const double* row_r = matrix[perm[r]];
+                result[r] -= CompensatedSum(ib, iend, [row_r, result](const long long j) { return row_r[j] * result[j]; }).value();
+            }
+        };
+
+        if (!parallel || ib < BACK_SUBST_CUTOFF)
+        {
+            update_rows(0, ib);
+        }
+        else
+        {
+            cilk_for (int rb = 0; rb < ib; rb += BACK_SUBST_ROWS)
+            {
+                update_rows(rb, std::min(rb + BACK_SUBST_ROWS, ib));
+            }
+        }
+    }
 }
 
 
 ///  ParalelGaussMethod()     
+///        ( PARTIAL_PIVOTING);
+///   ,   
 /// matrix -    ,   ,
 ///    -    
 /// rows -     
 /// result -   
-void ParallelGaussMethod(double **matrix, const int rows, double* result)
+void ParallelGaussMethod(Matrix& matrix, const int rows, double* result)
 {
+    std::vector<int> perm(rows);
+    std::iota(perm.begin(), perm.end(), 0);
+
     high_resolution_clock::time_point t1 = high_resolution_clock::now();
     //    
     for (int k = 0; k < rows; ++k)
     {
-        //
+        if (PARTIAL_PIVOTING)
+        {
+            std::swap(perm[k], perm[FindPivotRow(matrix, perm, k, rows)]);
+        }
+
+        const double* row_k = matrix[perm[k]];
+
+        cilk_for (int i = k + 1; i < rows; ++i)
+        {
+            double* row_i = matrix[perm[i]];
+            double koef = -row_i[k] / row_k[k];
+
+            Axpy(row_i + k, row_k + k, koef, rows + 1 - k);
+        }
+    }
+    high_resolution_clock::time_point t2 = high_resolution_clock::now();
+    parallelDuration = (t2 - t1);
+    Report("Parallel forward Gauss time - %f (%f GFLOP/s) \n",
+        parallelDuration.count(), GaussGflops(rows, parallelDuration));
+
+    //    
+    t1 = high_resolution_clock::now();
+    BackSubstitution(matrix, perm, rows, result);
+    t2 = high_resolution_clock::now();
+    Report("Parallel back substitution time - %f \n", duration<double>(t2 - t1).count());
+}
+
+
+///  FactorPanel()    [kb, kend)    
+/// ,      ;  
+///      
+/// matrix -  
+/// perm -  : perm[i] -     i
+/// rows -    
+/// kb, kend -  
+template <typename T>
+void FactorPanel(AlignedMatrix<T>& matrix, std::vector<int>& perm, const int rows, const int kb, const int kend)
+{
+    for (int k = kb; k < kend; ++k)
+    {
+        if (PARTIAL_PIVOTING)
+        {
+            std::swap(perm[k], perm[FindPivotRow(matrix, perm, k, rows)]);
+        }
+
+        const T* row_k = matrix[perm[k]];
+
         cilk_for (int i = k + 1; i < rows; ++i)
         {
-            double koef = -matrix[i][k] / matrix[k][k];
+            T* row_i = matrix[perm[i]];
+            const T koef = row_i[k] /= row_k[k];
 
-            for (int j = k; j <= rows; ++j)
+            Axpy(row_i + k + 1, row_k + k + 1, -koef, kend - k - 1);
+        }
+    }
+}
+
+
+///  UpdateTrailingTiles()   TILE_ROWS x TILE_COLS
+///   : A22 -= L21 * U12   [jbeg, jend)
+/// matrix -  
+/// phys_rows -    
+/// count -   
+/// u_rows -     ( U12)
+/// kb, kend -  
+/// jbeg, jend -   
+template <typename T>
+void UpdateTrailingTiles(AlignedMatrix<T>& matrix, const int* phys_rows, const int count, const int* u_rows,
+    const int kb, const int kend, const int jbeg, const int jend)
+{
+    cilk_for (int ib = 0; ib < count; ib += TILE_ROWS)
+    {
+        const int iend = std::min(ib + TILE_ROWS, count);
+
+        cilk_for (int jb = jbeg; jb < jend; jb += TILE_COLS)
+        {
+            const int jtile_end = std::min(jb + TILE_COLS, jend);
+
+            for (int i = ib; i < iend; ++i)
             {
-                matrix[i][j] += koef * matrix[k][j];
+                T* row_i = matrix[phys_rows[i]];
+
+                for (int k = kb; k < kend; ++k)
+                {
+                    const T* row_k = matrix[u_rows[k - kb]];
+                    const T koef = row_i[k];
+
+                    Axpy(row_i + jb, row_k + jb, -koef, jtile_end - jb);
+                }
             }
         }
     }
+}
+
+
+///  BlockedLUDecomposition()      :
+///       PANEL_SIZE ,  
+///     TILE_ROWS x TILE_COLS
+///    A22 -= L21 * U12.   (L)
+///      ,  - U.   
+///     ( PARTIAL_PIVOTING),   .
+///  LOOKAHEAD     ,   
+///        ,
+///        .
+/// matrix -  
+/// rows -   (  )  
+/// cols -   : rows -  ,
+/// rows + 1 -     
+/// perm -  : perm[i] -     i
+template <typename T>
+void BlockedLUDecomposition(AlignedMatrix<T>& matrix, const int rows, const int cols, std::vector<int>& perm)
+{
+    perm.resize(rows);
+    std::iota(perm.begin(), perm.end(), 0);
+
+    //     :   
+    //  perm,       
+    std::vector<int> step_rows(rows);
+
+    FactorPanel(matrix, perm, rows, 0, std::min(PANEL_SIZE, rows));
+
+    for (int kb = 0; kb < rows; kb += PANEL_SIZE)
+    {
+        const int kend = std::min(kb + PANEL_SIZE, rows);
+
+        if (kend == rows)
+        {
+            //  :      
+            for (int k = kb; k < kend && cols > rows; ++k)
+            {
+                const T rhs_k = matrix[perm[k]][rows];
+
+                for (int i = k + 1; i < rows; ++i)
+                {
+                    T* row_i = matrix[perm[i]];
+                    row_i[rows] -= row_i[k] * rhs_k;
+                }
+            }
+            break;
+        }
+
+        //     : U12 = L11^-1 * A12
+        cilk_for (int jb = kend; jb < cols; jb += TILE_COLS)
+        {
+            const int jend = std::min(jb + TILE_COLS, cols);
+
+            for (int k = kb; k < kend; ++k)
+            {
+                const T* row_k = matrix[perm[k]];
+
+                for (int i = k + 1; i < kend; ++i)
+                {
+                    T* row_i = matrix[perm[i]];
+                    const T koef = row_i[k];
+
+                    Axpy(row_i + jb, row_k + jb, -koef, jend - jb);
+                }
+            }
+        }
+
+        std::copy(perm.begin() + kb, perm.end(), step_rows.begin() + kb);
+        const int* u_rows = step_rows.data() + kb;
+        const int* trailing_rows = step_rows.data() + kend;
+        const int trailing_count = rows - kend;
+        const int next_end = std::min(kend + PANEL_SIZE, rows);
+
+        //    : A22 -= L21 * U12
+        if (LOOKAHEAD)
+        {
+            UpdateTrailingTiles(matrix, trailing_rows, trailing_count, u_rows, kb, kend, kend, next_end);
+
+            cilk_spawn FactorPanel(matrix, perm, rows, kend, next_end);
+            UpdateTrailingTiles(matrix, trailing_rows, trailing_count, u_rows, kb, kend, next_end, cols);
+            cilk_sync;
+        }
+        else
+        {
+            UpdateTrailingTiles(matrix, trailing_rows, trailing_count, u_rows, kb, kend, kend, cols);
+            FactorPanel(matrix, perm, rows, kend, next_end);
+        }
+    }
+}
+
+
+///  BlockedGaussMethod()     
+/// (  - BlockedLUDecomposition())
+/// matrix -    ,   ,
+///    -    
+/// rows -     
+/// result -   
+void BlockedGaussMethod(Matrix& matrix, const int rows, double* result)
+{
+    std::vector<int> perm;
+
+    high_resolution_clock::time_point t1 = high_resolution_clock::now();
+    BlockedLUDecomposition(matrix, rows, rows + 1, perm);
     high_resolution_clock::time_point t2 = high_resolution_clock::now();
-    parallelDuration = (t2 - t1);
-    printf("Parallel forward Gauss time - %f \n", parallelDuration.count());
+    blockedDuration = (t2 - t1);
+    Report("Blocked forward Gauss time - %f (%f GFLOP/s) \n",
+        blockedDuration.count(), GaussGflops(rows, blockedDuration));
 
     //    
-    result[rows - 1] = matrix[rows - 1][rows] / matrix[rows - 1][rows - 1];
+    BackSubstitution(matrix, perm, rows, result);
+}
+
 
-    for (int k = rows - 2; k >= 0; --k)
+///  LUSubstitution()   L * U * x = P * b  ,
+///  BlockedLUDecomposition();     
+///     
+/// lu - LU- 
+/// perm -  : perm[i] -     i
+/// rows -    
+/// b -  
+/// x - ,   
+template <typename T>
+void LUSubstitution(const AlignedMatrix<T>& lu, const std::vector<int>& perm, const int rows,
+    const double* b, double* x)
+{
+    //  : L * y = P * b ( L )
+    for (int i = 0; i < rows; ++i)
     {
-        //result[k] = matrix[k][rows];
-        cilk::reducer_opadd<double> result_k(matrix[k][rows]);
+        const T* row_l = lu[perm[i]];
+        double sum = b[perm[i]];
 
-        //
-        cilk_for (int j = k + 1; j < rows; ++j)
+        for (int k = 0; k < i; ++k)
         {
-            //result[k] -= matrix[k][j] * result[j];
-            result_k -= matrix[k][j] * result[j];
+            sum -= row_l[k] * x[k];
         }
 
-        //result[k] /= matrix[k][k];
-        result[k] = result_k->get_value() / matrix[k][k];
+        x[i] = sum;
+    }
+
+    //  : U * x = y
+    for (int i = rows - 1; i >= 0; --i)
+    {
+        const T* row_u = lu[perm[i]];
+        double sum = x[i];
+
+        for (int k = i + 1; k < rows; ++k)
+        {
+            sum -= row_u[k] * x[k];
+        }
+
+        x[i] = sum / row_u[i];
     }
 }
 
 
+///  CalcResidual()    r = b - A * x
+///       
+/// matrix -   ,   -  
+/// rows -    
+/// x -  
+/// residual - ,   
+double CalcResidual(const Matrix& matrix, const int rows, const double* x, double* residual)
+{
+    cilk_for (int i = 0; i < rows; ++i)
+    {
+        const double* row_i = matrix[i];
+        double sum = row_i[rows];
+
+        for (int j = 0; j < rows; ++j)
+        {
+            sum -= row_i[j] * x[j];
+        }
+
+        residual[i] = sum;
+    }
+
+    double norm = 0.0;
+    for (int i = 0; i < rows; ++i)
+    {
+        norm = std::max(norm, std::fabs(residual[i]));
+    }
+    return norm;
+}
+
+
+///  MixedPrecisionGaussMethod()     :
+///    O(n^3)     ( 
+///     ),     
+/// x += (LU)^-1 * (b - A * x)        .
+///   MAX_REFINEMENT_STEPS       ,
+///      .
+/// matrix -    ,   ,
+///    -    ;  
+/// rows -     
+/// result -   
+///   ,        
+///    mixedDuration, mixedSteps  mixedFallback.
+///    |b - A * x| / (|A| * |x|)   max
+double MixedPrecisionGaussMethod(const Matrix& matrix, const int rows, double* result)
+{
+    const high_resolution_clock::time_point solve_start = high_resolution_clock::now();
+
+    AlignedMatrix<float> lu(rows, rows);
+    std::vector<int> perm;
+
+    cilk_for (int i = 0; i < rows; ++i)
+    {
+        for (int j = 0; j < rows; ++j)
+        {
+            lu[i][j] = static_cast<float>(matrix[i][j]);
+        }
+    }
+
+    std::vector<double> b(rows);
+    std::vector<double> residual(rows);
+    std::vector<double> correction(rows);
+
+    double matrix_norm = 0.0;
+    for (int i = 0; i < rows; ++i)
+    {
+        double row_norm = 0.0;
+        for (int j = 0; j < rows; ++j)
+        {
+            row_norm += std::fabs(matrix[i][j]);
+        }
+        matrix_norm = std::max(matrix_norm, row_norm);
+        b[i] = matrix[i][rows];
+    }
+
+    //     LAPACK dsgesv: |r| <= sqrt(n) * eps * |A| * |x|
+    const double tolerance = std::sqrt(static_cast<double>(rows)) * DBL_EPSILON * matrix_norm;
+
+    bool converged = false;
+    int steps = 0;
+    double residual_norm = 0.0;
+    double solution_norm = 0.0;
+
+    high_resolution_clock::time_point t1 = high_resolution_clock::now();
+    try
+    {
+        BlockedLUDecomposition(lu, rows, rows, perm);
+        high_resolution_clock::time_point t2 = high_resolution_clock::now();
+        const duration<double> factor_duration = t2 - t1;
+        Report("Mixed precision forward Gauss time - %f (%f GFLOP/s) \n",
+            factor_duration.count(), GaussGflops(rows, factor_duration));
+
+        LUSubstitution(lu, perm, rows, b.data(), result);
+
+        for (;; ++steps)
+        {
+            residual_norm = CalcResidual(matrix, rows, result, residual.data());
+
+            solution_norm = 0.0;
+            for (int i = 0; i < rows; ++i)
+            {
+                solution_norm = std::max(solution_norm, std::fabs(result[i]));
+            }
+
+            if (residual_norm <= tolerance * solution_norm)
+            {
+                converged = true;
+                break;
+            }
+            if (steps == MAX_REFINEMENT_STEPS)
+            {
+                break;
+            }
+
+            LUSubstitution(lu, perm, rows, residual.data(), correction.data());
+            for (int i = 0; i < rows; ++i)
+            {
+                result[i] += correction[i];
+            }
+        }
+    }
+    catch (const std::runtime_error&)
+    {
+        //     
+        converged = false;
+    }
+
+    if (!converged)
+    {
+        Report("Mixed precision refinement did not converge, falling back to double precision \n");
+
+        Matrix work(rows, rows + 1);
+        cilk_for (int i = 0; i < rows; ++i)
+        {
+            std::copy(matrix[i], matrix[i] + rows + 1, work[i]);
+        }
+
+        BlockedLUDecomposition(work, rows, rows + 1, perm);
+        BackSubstitution(work, perm, rows, result);
+
+        residual_norm = CalcResidual(matrix, rows, result, residual.data());
+        solution_norm = 0.0;
+        for (int i = 0; i < rows; ++i)
+        {
+            solution_norm = std::max(solution_norm, std::fabs(result[i]));
+        }
+    }
+
+    const double relative_residual = residual_norm / (matrix_norm * solution_norm);
+
+    mixedDuration = high_resolution_clock::now() - solve_start;
+    mixedSteps = steps;
+    mixedFallback = !converged;
+    Report("Mixed precision solve time - %f, refinement steps - %d, fallback to double - %s, relative residual - %e \n",
+        mixedDuration.count(), steps, converged ? "no" : "yes", relative_residual);
+
+    return relative_residual;
+}
+
+
+///  LUFactorization  LU-     
+/// .      O(n^3),    
+///         O(n^2).
+class LUFactorization
+{
+public:
+    ///  Factor()      
+    /// <i>rows</i>  <i>matrix</i>;    
+    void Factor(const Matrix& matrix, const int rows);
+
+    ///  Solve()      ;
+    /// rhs -  rows x m, j-   - j-  
+    /// solution - ,       
+    void Solve(const Matrix& rhs, Matrix& solution) const;
+
+    int rows() const { return rows_; }
+
+private:
+    Matrix lu_;
+    std::vector<int> perm_;
+    int rows_ = 0;
+};
+
+
+void LUFactorization::Factor(const Matrix& matrix, const int rows)
+{
+    rows_ = rows;
+    lu_.resize(rows, rows);
+
+    cilk_for (int i = 0; i < rows; ++i)
+    {
+        std::copy(matrix[i], matrix[i] + rows, lu_[i]);
+    }
+
+    BlockedLUDecomposition(lu_, rows, rows, perm_);
+}
+
+
+void LUFactorization::Solve(const Matrix& rhs, Matrix& solution) const
+{
+    const int rows = rows_;
+    const int count = static_cast<int>(rhs.cols());
+    solution.resize(rows, count);
+
+    //   :   RHS_TILE   ,
+    //     L  U    RHS_TILE 
+    cilk_for (int cb = 0; cb < count; cb += RHS_TILE)
+    {
+        const int width = std::min(RHS_TILE, count - cb);
+
+        //  : y = P * b
+        for (int i = 0; i < rows; ++i)
+        {
+            std::copy(rhs[perm_[i]] + cb, rhs[perm_[i]] + cb + width, solution[i] + cb);
+        }
+
+        //  : L * y = P * b ( L )
+        for (int i = 1; i < rows; ++i)
+        {
+            const double* row_l = lu_[perm_[i]];
+            double* y_i = solution[i] + cb;
+
+            for (int k = 0; k < i; ++k)
+            {
+                Axpy(y_i, solution[k] + cb, -row_l[k], width);
+            }
+        }
+
+        //  : U * x = y
+        for (int i = rows - 1; i >= 0; --i)
+        {
+            const double* row_u = lu_[perm_[i]];
+            double* x_i = solution[i] + cb;
+
+            for (int k = i + 1; k < rows; ++k)
+            {
+                Axpy(x_i, solution[k] + cb, -row_u[k], width);
+            }
+
+            const double inv_diag = 1.0 / row_u[i];
+            for (int j = 0; j < width; ++j)
+            {
+                x_i[j] *= inv_diag;
+            }
+        }
+    }
+}
+
+
+///  RunBandedAndSparseExamples()     
+/// BAND_MATRIX_SIZE       SPARSE_GRID_SIZE x SPARSE_GRID_SIZE
+///          .  
+///  :  BandedSolve()  BandedGaussMethod(),  
+///        (  )
+void RunBandedAndSparseExamples()
+{
+    //      (   
+    //     );   
+    //  :  (i, j)  -     i * (2 * half + 1) + j - i + half,
+    //    i -    band_rows * (2 * half + 1) + i,
+    //       
+    const int band_rows = BAND_MATRIX_SIZE;
+    const int half = BAND_HALF_WIDTH;
+    const PhiloxRng band_rng(randomSeed);
+    auto band_value = [half, band_rows, &band_rng](const int i, const int j) -> double
+    {
+        const long long width = 2 * half + 1;
+        const long long index = j == band_rows ? band_rows * width + i : i * width + j - i + half;
+        const double value = band_rng.UniformInt(index, 1, 2500);
+        return i == j ? value + 2 * half * 2500 : value;
+    };
+
+    std::vector<double> rhs(band_rows);
+    std::vector<double> x(band_rows);
+    cilk_for (int i = 0; i < band_rows; ++i)
+    {
+        rhs[i] = band_value(i, band_rows);
+    }
+
+    auto fill_band = [&](BandMatrix& band)
+    {
+        cilk_for (int i = 0; i < band_rows; ++i)
+        {
+            for (int j = std::max(i - half, 0); j <= std::min(i + half, band_rows - 1); ++j)
+            {
+                band.at(i, j) = band_value(i, j);
+            }
+        }
+    };
+
+    auto band_residual = [&]()
+    {
+        double residual = 0.0;
+        for (int i = 0; i < band_rows; ++i)
+        {
+            double sum = rhs[i];
+            for (int j = std::max(i - half, 0); j <= std::min(i + half, band_rows - 1); ++j)
+            {
+                sum -= band_value(i, j) * x[j];
+            }
+            residual = std::max(residual, std::fabs(sum));
+        }
+        return residual;
+    };
+
+    //     
+    BandMatrix serial_band(band_rows, half, half);
+    fill_band(serial_band);
+    std::copy(rhs.begin(), rhs.end(), x.begin());
+
+    high_resolution_clock::time_point t1 = high_resolution_clock::now();
+    BandedSolve(serial_band, x.data(), 1);
+    high_resolution_clock::time_point t2 = high_resolution_clock::now();
+
+    printf("Serial banded Gauss time for %d rows, half-width %d - %f, residual - %e \n",
+        band_rows, half, duration<double>(t2 - t1).count(), band_residual());
+
+    // BandedGaussMethod()     ,   
+    BandMatrix band(band_rows, half, half);
+    fill_band(band);
+
+    t1 = high_resolution_clock::now();
+    const int partitions = BandedGaussMethod(band, rhs.data(), x.data());
+    t2 = high_resolution_clock::now();
+
+    printf("Banded Gauss time for %d rows, half-width %d (%d partitions) - %f, residual - %e \n",
+        band_rows, half, partitions, duration<double>(t2 - t1).count(), band_residual());
+
+    //       
+    const int grid = SPARSE_GRID_SIZE;
+    const int sparse_rows = grid * grid;
+
+    //   - :   i      i
+    const PhiloxRng label_rng(randomSeed + 1);
+    std::vector<int> label(sparse_rows);
+    std::iota(label.begin(), label.end(), 0);
+    for (int i = sparse_rows - 1; i > 0; --i)
+    {
+        std::swap(label[i], label[label_rng.UniformInt(i, 0, i)]);
+    }
+
+    std::vector<std::vector<std::pair<int, double>>> entries(sparse_rows);
+    for (int gy = 0; gy < grid; ++gy)
+    {
+        for (int gx = 0; gx < grid; ++gx)
+        {
+            const int row = label[gy * grid + gx];
+            entries[row].push_back({ row, 4.5 });
+            if (gx > 0) entries[row].push_back({ label[gy * grid + gx - 1], -1.0 });
+            if (gx + 1 < grid) entries[row].push_back({ label[gy * grid + gx + 1], -1.0 });
+            if (gy > 0) entries[row].push_back({ label[(gy - 1) * grid + gx], -1.0 });
+            if (gy + 1 < grid) entries[row].push_back({ label[(gy + 1) * grid + gx], -1.0 });
+        }
+    }
+
+    SparseMatrix sparse;
+    sparse.rows = sparse_rows;
+    sparse.row_ptr.push_back(0);
+    std::vector<double> sparse_rhs(sparse_rows, 0.0);
+    for (int i = 0; i < sparse_rows; ++i)
+    {
+        for (const auto& entry : entries[i])
+        {
+            sparse.col_idx.push_back(entry.first);
+            sparse.values.push_back(entry.second);
+            //    ,   -   
+            sparse_rhs[i] += entry.second;
+        }
+        sparse.row_ptr.push_back(static_cast<int>(sparse.col_idx.size()));
+    }
+
+    std::vector<double> sparse_x(sparse_rows);
+    t1 = high_resolution_clock::now();
+    const int bandwidth = SparseGaussMethod(sparse, sparse_rhs.data(), sparse_x.data());
+    t2 = high_resolution_clock::now();
+
+    double error = 0.0;
+    for (int i = 0; i < sparse_rows; ++i)
+    {
+        error = std::max(error, std::fabs(sparse_x[i] - 1.0));
+    }
+    printf("Sparse Gauss time for %d rows (bandwidth after RCM - %d) - %f, error - %e \n",
+        sparse_rows, bandwidth, duration<double>(t2 - t1).count(), error);
+}
+
+
+///  RunGaussBenchmark()         
+/// BenchmarkHarness      BENCHMARK_SIZES   
+/// BENCHMARK_WORKERS; ,  ,      
+/// .       |b - A * x| / (|A| * |x|)
+///  ,  ,      .
+void RunGaussBenchmark()
+{
+    verboseOutput = false;
+
+    Matrix original;
+    Matrix work;
+    std::vector<double> x;
+    std::vector<double> residual;
+    double matrix_norm = 0.0;
+    LUFactorization lu;
+    Matrix rhs;
+    Matrix solution;
+    int factored_size = 0;
+
+    //       
+    auto prepare_original = [&](const long long size)
+    {
+        const int rows = static_cast<int>(size);
+        if (static_cast<int>(original.rows()) != rows)
+        {
+            original.resize(rows, rows + 1);
+            randomSeed = static_cast<unsigned long long>(rows);
+            InitMatrix(original);
+            x.assign(rows, 1.0);
+            residual.resize(rows);
+
+            matrix_norm = 0.0;
+            for (int i = 0; i < rows; ++i)
+            {
+                double row_norm = 0.0;
+                for (int j = 0; j < rows; ++j)
+                {
+                    row_norm += std::fabs(original[i][j]);
+                }
+                matrix_norm = std::max(matrix_norm, row_norm);
+            }
+        }
+    };
+    auto prepare_copy = [&](const long long size)
+    {
+        prepare_original(size);
+        const int rows = static_cast<int>(size);
+        work.resize(rows, rows + 1);
+        cilk_for (int i = 0; i < rows; ++i)
+        {
+            std::copy(original[i], original[i] + rows + 1, work[i]);
+        }
+    };
+    auto prepare_factor = [&](const long long size)
+    {
+        prepare_original(size);
+        const int rows = static_cast<int>(size);
+        if (factored_size != rows)
+        {
+            lu.Factor(original, rows);
+            rhs.resize(rows, RHS_COUNT);
+            for (int i = 0; i < rows; ++i)
+            {
+                std::fill(rhs[i], rhs[i] + RHS_COUNT, original[i][rows]);
+            }
+            factored_size = rows;
+        }
+    };
+
+    //       
+    auto solve_flops = [](const long long size)
+    {
+        return GaussFlops(static_cast<int>(size)) + static_cast<double>(size) * size;
+    };
+    //    x
+    auto relative_residual = [&](const long long size)
+    {
+        const int rows = static_cast<int>(size);
+        double solution_norm = 0.0;
+        for (int i = 0; i < rows; ++i)
+        {
+            solution_norm = std::max(solution_norm, std::fabs(x[i]));
+        }
+        return CalcResidual(original, rows, x.data(), residual.data()) / (matrix_norm * solution_norm);
+    };
+
+    BenchmarkHarness harness;
+    harness.Add("init_matrix", prepare_copy, [&](const long long) { InitMatrix(work); });
+    harness.Add("serial_gauss", prepare_copy, [&](const long long size)
+    {
+        SerialGaussMethod(work, static_cast<int>(size), x.data());
+    }, solve_flops, relative_residual);
+    harness.Add("parallel_gauss", prepare_copy, [&](const long long size)
+    {
+        ParallelGaussMethod(work, static_cast<int>(size), x.data());
+    }, solve_flops, relative_residual);
+    harness.Add("blocked_gauss", prepare_copy, [&](const long long size)
+    {
+        BlockedGaussMethod(work, static_cast<int>(size), x.data());
+    }, solve_flops, relative_residual);
+    harness.Add("mixed_gauss", prepare_original, [&](const long long size)
+    {
+        KeepResult(MixedPrecisionGaussMethod(original, static_cast<int>(size), x.data()));
+    }, solve_flops, relative_residual);
+    harness.Add("lu_factor", prepare_original, [&](const long long size)
+    {
+        lu.Factor(original, static_cast<int>(size));
+        factored_size = 0;
+    }, [](const long long size) { return GaussFlops(static_cast<int>(size)); }, BenchmarkHarness::Check());
+    //       (  rhs )
+    harness.Add("lu_solve", prepare_factor, [&](const long long) { lu.Solve(rhs, solution); },
+        [](const long long size) { return 2.0 * size * size * RHS_COUNT; },
+        [&](const long long size)
+        {
+            for (int i = 0; i < static_cast<int>(size); ++i)
+            {
+                x[i] = solution[i][0];
+            }
+            return relative_residual(size);
+        });
+    harness.Add("residual", prepare_original, [&](const long long size)
+    {
+        KeepResult(CalcResidual(original, static_cast<int>(size), x.data(), residual.data()));
+    });
+
+    BenchmarkOptions options;
+    options.sizes.assign(std::begin(BENCHMARK_SIZES), std::end(BENCHMARK_SIZES));
+    options.workers.assign(std::begin(BENCHMARK_WORKERS), std::end(BENCHMARK_WORKERS));
+    options.warmup = 1;
+    options.repeats = BENCHMARK_REPEATS;
+    harness.Run(options);
+
+    verboseOutput = true;
+}
+
+
 int main()
 {
-	srand( (unsigned) time( 0 ) );
+    randomSeed = static_cast<unsigned long long>(time(0));
+
+    if (BENCHMARK_MODE)
+    {
+        RunGaussBenchmark();
+        return 0;
+    }
 
     __cilkrts_set_param("nworkers", "4");
 
+    printf("Row update kernel - %s \n", SimdIsaName(DetectSimdIsa()));
+
 	// -   ,    
 	const int matrix_lines = TEST_MODE ? 4 : MATRIX_SIZE;
 
-	double **matrix = new double*[matrix_lines];
-
-	//   
-	for ( int i = 0; i < matrix_lines; ++i )
-	{
-		// (test_matrix_lines + 1)-     ,
-		//        ,   
-		matrix[i] = new double[matrix_lines + 1];
-	}
+	// (matrix_lines + 1)-    ,
+	//        ,   ;
+	//        
+	Matrix matrix(matrix_lines, matrix_lines + 1);
 
 	//   
 	double *result  = new double[matrix_lines];
@@ -189,6 +1116,19 @@ int main()
 
     printf("Acceleration for %dx%d matrix - %f \n",
         matrix_lines, matrix_lines, serialDuration.count() / parallelDuration.count());
+
+    InitMainMatrix(matrix);
+    BlockedGaussMethod( matrix, matrix_lines, result );
+
+    printf("Blocked acceleration for %dx%d matrix - %f \n",
+        matrix_lines, matrix_lines, serialDuration.count() / blockedDuration.count());
+
+    InitMainMatrix(matrix);
+    MixedPrecisionGaussMethod( matrix, matrix_lines, result );
+
+    //    -    ,    -  
+    printf("Mixed precision acceleration for %dx%d matrix (whole solve) - %f, refinement steps - %d, fallback to double - %s \n",
+        matrix_lines, matrix_lines, serialDuration.count() / mixedDuration.count(), mixedSteps, mixedFallback ? "yes" : "no");
     if (TEST_MODE)
     {
         printf("Solution:\n");
@@ -198,13 +1138,47 @@ int main()
         }
     }
 
-    //  
-	for ( int i = 0; i < matrix_lines; ++i )
-	{
-		delete[] matrix[i];
-	}
+    //  :   ,    ;
+    //    -     
+    InitMainMatrix(matrix);
+
+    Matrix rhs(matrix_lines, RHS_COUNT);
+    Matrix solution;
+    const PhiloxRng rhs_rng(randomSeed + 1);
+    for (int i = 0; i < matrix_lines; ++i)
+    {
+        rhs[i][0] = matrix[i][matrix_lines];
+        FillUniformInt(rhs[i] + 1, static_cast<long long>(i) * RHS_COUNT, RHS_COUNT - 1, rhs_rng, 1, 2500);
+    }
+
+    LUFactorization lu;
+
+    high_resolution_clock::time_point t1 = high_resolution_clock::now();
+    lu.Factor(matrix, matrix_lines);
+    high_resolution_clock::time_point t2 = high_resolution_clock::now();
+    lu.Solve(rhs, solution);
+    high_resolution_clock::time_point t3 = high_resolution_clock::now();
+
+    factorDuration = (t2 - t1);
+    solveDuration = (t3 - t2);
+    printf("LU factorization time - %f, solve time for %d right-hand sides - %f (%f per vector) \n",
+        factorDuration.count(), RHS_COUNT, solveDuration.count(), solveDuration.count() / RHS_COUNT);
 
-    delete[] matrix;
+    if (TEST_MODE)
+    {
+        printf("Solution by LU factorization:\n");
+        for (int i = 0; i < matrix_lines; ++i)
+        {
+            printf("x(%d) = %lf\n", i, solution[i][0]);
+        }
+    }
+
+    if (!TEST_MODE)
+    {
+        RunBandedAndSparseExamples();
+    }
+
+    //  
 	delete[] result;
 
 	return 0;
@@ -1,10 +1,16 @@
 ﻿#include <vector>
+#include <algorithm>
 #include <thread>
 #include <stdio.h>
 #include <exception>
+#include <functional>
 #include <locale.h>
 #include <cilk/cilk.h>
-#include <cilk/reducer_opadd.h>
+
+#include "../../common/aligned_matrix.h"
+#include "../../common/benchmark.h"
+#include "../../common/counter_rng.h"
+#include "../../common/deterministic_sum.h"
 
 /// перечисление, определяющее как будет происходить вычисление
 /// средних значений матрицы: по строкам или по столбцам
@@ -14,26 +20,42 @@ enum class eprocess_type
    by_cols
 };
 
-void InitMatrix(double** matrix, const size_t numb_rows, const size_t numb_cols)
+/// матрица хранится одним выровненным блоком с шагом строки stride()
+using Matrix = AlignedMatrix<double>;
+
+/// режим замеров: вместо примера функции программы прогоняются через
+/// BenchmarkHarness на квадратных матрицах, результаты печатаются в формате CSV
+constexpr bool MICROBENCHMARK_MODE = false;
+
+/// наибольшее количество частей, на которые делятся строки при поиске средних по столбцам,
+/// и наименьшее количество строк в части (чтобы на низких матрицах векторы сумм частей
+/// не перевешивали саму матрицу)
+constexpr size_t AVERAGE_ROW_PARTITIONS = 64;
+constexpr size_t AVERAGE_MIN_PARTITION_ROWS = 64;
+/// ширина полосы столбцов, суммы которой держатся в кэше L1 при проходе части строк
+constexpr size_t AVERAGE_COL_TILE = 2048;
+
+/// Функция InitMatrix() заполняет матрицу <i>matrix</i> случайными значениями от 1 до 5:
+/// элемент (i, j) - число счетчикового генератора с номером i * cols + j, поэтому
+/// строки заполняются параллельно, а результат зависит только от <i>seed</i>
+void InitMatrix(Matrix& matrix, const unsigned long long seed)
 {
-   for (size_t i = 0; i < numb_rows; ++i)
+   const PhiloxRng rng(seed);
+   const long long cols = static_cast<long long>(matrix.cols());
+
+   cilk_for (size_t i = 0; i < matrix.rows(); ++i)
    {
-      for (size_t j = 0; j < numb_cols; ++j)
-      {
-         matrix[i][j] = rand() % 5 + 1;
-      }
+      FillUniformInt(matrix[i], i * cols, cols, rng, 1, 5);
    }
 }
 
-/// Функция PrintMatrix() печатает элементы матрицы <i>matrix</i> на консоль;
-/// numb_rows - количество строк в исходной матрице <i>matrix</i>
-/// numb_cols - количество столбцов в исходной матрице <i>matrix</i>
-void PrintMatrix(double** matrix, const size_t numb_rows, const size_t numb_cols)
+/// Функция PrintMatrix() печатает элементы матрицы <i>matrix</i> на консоль
+void PrintMatrix(const Matrix& matrix)
 {
    printf("Generated matrix:\n");
-   for (size_t i = 0; i < numb_rows; ++i)
+   for (size_t i = 0; i < matrix.rows(); ++i)
    {
-      for (size_t j = 0; j < numb_cols; ++j)
+      for (size_t j = 0; j < matrix.cols(); ++j)
       {
          printf("%lf ", matrix[i][j]);
       }
@@ -45,37 +67,65 @@ void PrintMatrix(double** matrix, const size_t numb_rows, const size_t numb_cols
 /// по строкам, либо по столбцам в зависимости от значения параметра <i>proc_type</i>;
 /// proc_type - признак, в зависимости от которого средние значения вычисляются 
 /// либо по строкам, либо по стобцам исходной матрицы <i>matrix</i>
+/// Суммы строк считаются функцией DeterministicSum(); суммы столбцов - проходом
+/// по строкам подряд: каждая из AVERAGE_ROW_PARTITIONS частей строк копит компенсированные
+/// суммы всех столбцов в своих векторах, которые затем прибавляются к суммам части 0
+/// в порядке частей.
+/// Поэтому в обоих случаях результат не зависит от количества исполнителей
 /// matrix - исходная матрица
-/// numb_rows - количество строк в исходной матрице <i>matrix</i>
-/// numb_cols - количество столбцов в исходной матрице <i>matrix</i>
 /// average_vals - массив, куда сохраняются вычисленные средние значения
-void FindAverageValues(eprocess_type proc_type, double** matrix, const size_t numb_rows, const size_t numb_cols, double* average_vals)
+void FindAverageValues(eprocess_type proc_type, const Matrix& matrix, double* average_vals)
 {
+   const size_t numb_rows = matrix.rows();
+   const size_t numb_cols = matrix.cols();
+
    switch (proc_type)
    {
    case eprocess_type::by_rows:
    {
       cilk_for (size_t i = 0; i < numb_rows; ++i)
       {
-         cilk::reducer_opadd<double> sum(0.0);
-         cilk_for (size_t j = 0; j < numb_cols; ++j)
-         {
-            sum += matrix[i][j];
-         }
-         average_vals[i] = sum.get_value() / numb_cols;
+         const double* row = matrix[i];
+         const double sum = DeterministicSum(numb_cols, [row](const long long j) { return row[j]; });
+         average_vals[i] = sum / numb_cols;
       }
       break;
    }
    case eprocess_type::by_cols:
    {
-      cilk_for (size_t j = 0; j < numb_cols; ++j)
+      const size_t partitions = std::min(AVERAGE_ROW_PARTITIONS, std::max<size_t>(numb_rows / AVERAGE_MIN_PARTITION_ROWS, 1));
+      std::vector<double> sums(partitions * numb_cols, 0.0);
+      std::vector<double> compensations(partitions * numb_cols, 0.0);
+
+      cilk_for (size_t p = 0; p < partitions; ++p)
       {
-         cilk::reducer_opadd<double> sum(0.0);
-         cilk_for (size_t i = 0; i < numb_rows; ++i)
+         double* part_sums = &sums[p * numb_cols];
+         double* part_compensations = &compensations[p * numb_cols];
+         const size_t first = p * numb_rows / partitions;
+         const size_t last = (p + 1) * numb_rows / partitions;
+         for (size_t jb = 0; jb < numb_cols; jb += AVERAGE_COL_TILE)
          {
-            sum += matrix[i][j];
+            const size_t width = std::min(AVERAGE_COL_TILE, numb_cols - jb);
+            for (size_t i = first; i < last; ++i)
+            {
+               CompensatedAdd(part_sums + jb, part_compensations + jb, matrix[i] + jb, width);
+            }
+         }
+      }
+
+      // суммы частей прибавляются к части 0 построчно; полосы столбцов независимы
+      cilk_for (size_t jb = 0; jb < numb_cols; jb += AVERAGE_COL_TILE)
+      {
+         const size_t width = std::min(AVERAGE_COL_TILE, numb_cols - jb);
+         for (size_t p = 1; p < partitions; ++p)
+         {
+            CompensatedAdd(&sums[jb], &compensations[jb], &sums[p * numb_cols + jb],
+               &compensations[p * numb_cols + jb], width);
+         }
+         for (size_t j = jb; j < jb + width; ++j)
+         {
+            average_vals[j] = (sums[j] + compensations[j]) / numb_rows;
          }
-         average_vals[j] = sum.get_value() / numb_rows;
       }
       break;
    }
@@ -101,7 +151,7 @@ void PrintAverageVals(eprocess_type proc_type, double* average_vals, const size_
       printf("\nAverage values in rows:\n");
       for (size_t i = 0; i < dimension; ++i)
       {
-         printf("Row %u: %lf\n", i, average_vals[i]);
+         printf("Row %zu: %lf\n", i, average_vals[i]);
       }
       break;
    }
@@ -110,7 +160,7 @@ void PrintAverageVals(eprocess_type proc_type, double* average_vals, const size_
       printf("\nAverage values in columns:\n");
       for (size_t i = 0; i < dimension; ++i)
       {
-         printf("Column %u: %lf\n", i, average_vals[i]);
+         printf("Column %zu: %lf\n", i, average_vals[i]);
       }
       break;
    }
@@ -122,6 +172,43 @@ void PrintAverageVals(eprocess_type proc_type, double* average_vals, const size_
 }
 
 
+/// Функция RunMicrobenchmarks() регистрирует заполнение матрицы и поиск средних
+/// значений как замеры BenchmarkHarness и прогоняет их по размерам квадратной
+/// матрицы и количествам исполнителей
+/// seed - начальное значение генератора элементов матрицы
+void RunMicrobenchmarks(const unsigned long long seed)
+{
+   Matrix matrix;
+   std::vector<double> average_vals;
+
+   auto prepare = [&](const long long size)
+   {
+      if (static_cast<long long>(matrix.rows()) != size)
+      {
+         matrix.resize(size, size);
+         InitMatrix(matrix, seed);
+         average_vals.resize(size);
+      }
+   };
+
+   BenchmarkHarness harness;
+   harness.Add("init_matrix", prepare, [&](const long long) { InitMatrix(matrix, seed); });
+   harness.Add("average_by_rows", prepare, [&](const long long)
+   {
+      FindAverageValues(eprocess_type::by_rows, matrix, average_vals.data());
+   });
+   harness.Add("average_by_cols", prepare, [&](const long long)
+   {
+      FindAverageValues(eprocess_type::by_cols, matrix, average_vals.data());
+   });
+
+   BenchmarkOptions options;
+   options.sizes = { 256, 1024, 4096 };
+   options.workers = { 1, 2, 4, 8 };
+   harness.Run(options);
+}
+
+
 int main()
 {
    const unsigned ERROR_STATUS = -1;
@@ -131,27 +218,29 @@ int main()
 
    try
    {
-      srand((unsigned)time(0));
+      const unsigned long long seed = static_cast<unsigned long long>(time(0));
+
+      if (MICROBENCHMARK_MODE)
+      {
+         RunMicrobenchmarks(seed);
+         return OK_STATUS;
+      }
 
       const size_t numb_rows = 2;
       const size_t numb_cols = 3;
 
       // allocate memory
-      double** matrix = new double*[numb_rows];
-      for (size_t i = 0; i < numb_rows; ++i)
-      {
-         matrix[i] = new double[numb_cols];
-      }
+      Matrix matrix(numb_rows, numb_cols);
 
       double* average_vals_in_rows = new double[numb_rows];
       double* average_vals_in_cols = new double[numb_cols];
 
-      InitMatrix(matrix, numb_rows, numb_cols);
+      InitMatrix(matrix, seed);
 
-      PrintMatrix(matrix, numb_rows, numb_cols);
+      PrintMatrix(matrix);
 
-      std::thread first_thr(FindAverageValues, eprocess_type::by_rows, matrix, numb_rows, numb_cols, average_vals_in_rows);
-      std::thread second_thr(FindAverageValues, eprocess_type::by_cols, matrix, numb_rows, numb_cols, average_vals_in_cols);
+      std::thread first_thr(FindAverageValues, eprocess_type::by_rows, std::cref(matrix), average_vals_in_rows);
+      std::thread second_thr(FindAverageValues, eprocess_type::by_cols, std::cref(matrix), average_vals_in_cols);
 
       first_thr.join();
       second_thr.join();
@@ -160,12 +249,6 @@ int main()
       PrintAverageVals(eprocess_type::by_cols, average_vals_in_cols, numb_cols);
 
       // clear memory
-      for (size_t i = 0; i < numb_rows; ++i)
-      {
-         delete[] matrix[i];
-      }
-      delete[] matrix;
-
       delete[] average_vals_in_rows;
       delete[] average_vals_in_cols;
    }